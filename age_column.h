@@ -0,0 +1,264 @@
+// age_column - a compact container of ages, one byte per age
+//
+// https://en.cppreference.com/w/cpp/types/integer
+
+#ifndef SAM206_AGE_COLUMN_H
+#define SAM206_AGE_COLUMN_H
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "age_histogram.h"
+#include "predicate.h"
+
+/**
+ *  AgeColumn
+ *  A vector<int> uses 4 bytes for every age, but every age fits in one byte
+ *  (0..255).  AgeColumn stores the ages as uint8_t, so it needs a quarter of
+ *  the memory, and a SIMD register holds four times as many ages.
+ *
+ *  It looks like a vector<int> from the outside: the iterators, operator[]
+ *  and at() give int values, so the code in main.cpp works unchanged:
+ *      begin/end, cbegin/cend, erase, pop_back, push_back, clear
+ *  and the std:: algorithms count, count_if, find, find_if all accept its
+ *  iterators.  The member functions count(), count_if(), find() and
+ *  find_if() do the same job, but work directly on the bytes.
+ *
+ *  push_back() is the "checked path": it throws out_of_range for an age
+ *  that does not fit in a byte, instead of silently truncating it.
+ *  The elements are read-only through iterators; use set() to change one.
+ *
+ *  enable_histogram() attaches an AgeHistogram (see age_histogram.h) that
+ *  every push_back, pop_back, erase, set and clear keeps up to date.  While
+ *  it is attached, count() is O(1), all_of() and none_of() are O(1) for
+ *  interval predicates such as x > 16, and count_if() looks at the 256
+ *  bins instead of at every age.
+ */
+class AgeColumn {
+public:
+    static constexpr int MIN_AGE = 0;
+    static constexpr int MAX_AGE = UINT8_MAX;
+
+    // Random access iterator that reads each byte as an int
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = int;
+
+        const_iterator() = default;
+        explicit const_iterator(const std::uint8_t* p) : p(p) {}
+
+        int operator*() const { return *p; }
+        int operator[](difference_type n) const { return p[n]; }
+
+        const_iterator& operator++() { ++p; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++p; return old; }
+        const_iterator& operator--() { --p; return *this; }
+        const_iterator operator--(int) { const_iterator old = *this; --p; return old; }
+        const_iterator& operator+=(difference_type n) { p += n; return *this; }
+        const_iterator& operator-=(difference_type n) { p -= n; return *this; }
+
+        friend const_iterator operator+(const_iterator it, difference_type n) { return it += n; }
+        friend const_iterator operator+(difference_type n, const_iterator it) { return it += n; }
+        friend const_iterator operator-(const_iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const_iterator a, const_iterator b) { return a.p - b.p; }
+
+        bool operator==(const const_iterator&) const = default;
+        auto operator<=>(const const_iterator&) const = default;
+
+        const std::uint8_t* base() const { return p; }
+
+    private:
+        const std::uint8_t* p = nullptr;
+    };
+    using iterator = const_iterator;
+    using value_type = int;
+    using size_type = std::size_t;
+
+    AgeColumn() = default;
+    AgeColumn(std::initializer_list<int> ages)
+    {
+        reserve(ages.size());
+        for (int age : ages)
+            push_back(age);
+    }
+
+    static bool fits(int age) { return age >= MIN_AGE && age <= MAX_AGE; }
+
+    void push_back(int age)
+    {
+        if (!fits(age))
+            throw std::out_of_range("AgeColumn: age " + std::to_string(age) + " does not fit in a byte");
+        bytes.push_back(std::uint8_t(age));
+        if (hist)
+            hist->add(age);
+    }
+
+    void set(size_type i, int age)
+    {
+        if (!fits(age))
+            throw std::out_of_range("AgeColumn: age " + std::to_string(age) + " does not fit in a byte");
+        if (hist) {
+            hist->remove(bytes.at(i));
+            hist->add(age);
+        }
+        bytes.at(i) = std::uint8_t(age);
+    }
+
+    void pop_back()
+    {
+        if (hist)
+            hist->remove(bytes.back());
+        bytes.pop_back();
+    }
+    void clear()
+    {
+        bytes.clear();
+        if (hist)
+            hist->clear();
+    }
+    void reserve(size_type n) { bytes.reserve(n); }
+
+    iterator erase(const_iterator pos)
+    {
+        if (hist)
+            hist->remove(*pos);
+        return make_iterator(bytes.erase(to_vector_iterator(pos)));
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        if (hist)
+            for (const_iterator it = first; it != last; ++it)
+                hist->remove(*it);
+        return make_iterator(bytes.erase(to_vector_iterator(first), to_vector_iterator(last)));
+    }
+
+    // Build the histogram from the current ages (O(n)) and keep it up to date
+    void enable_histogram()
+    {
+        hist.emplace();
+        for (std::uint8_t age : bytes)
+            hist->add(age);
+    }
+    void disable_histogram() { hist.reset(); }
+    bool has_histogram() const { return hist.has_value(); }
+    const AgeHistogram& histogram() const { return hist.value(); }
+
+    size_type size() const { return bytes.size(); }
+    bool empty() const { return bytes.empty(); }
+    int operator[](size_type i) const { return bytes[i]; }
+    int at(size_type i) const { return bytes.at(i); }
+    const std::uint8_t* data() const { return bytes.data(); }
+
+    const_iterator begin() const { return const_iterator(bytes.data()); }
+    const_iterator end() const { return const_iterator(bytes.data() + bytes.size()); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    /**
+     * Count the ages equal to "age" - same answer as count(cbegin(), cend(), age).
+     * The bytes are compared in blocks of 255 with a byte-sized counter,
+     * so a 32-byte AVX2 register tests 32 ages per instruction.
+     */
+    std::ptrdiff_t count(int age) const
+    {
+        if (!fits(age))
+            return 0;
+        if (hist)
+            return hist->count(age);
+        const std::uint8_t needle = std::uint8_t(age);
+        const std::uint8_t* p = bytes.data();
+        const std::uint8_t* last = p + bytes.size();
+        std::ptrdiff_t n = 0;
+        while (last - p >= 255) {
+            std::uint8_t block = 0;     // at most 255 matches - cannot overflow
+            for (int i = 0; i < 255; i++)
+                block += (p[i] == needle);
+            n += block;
+            p += 255;
+        }
+        for (; p != last; ++p)
+            n += (*p == needle);
+        return n;
+    }
+
+    // Same as count_if(cbegin(), cend(), e) for a predicate from predicate.h
+    template <typename P>
+    std::ptrdiff_t count_if(const pred::Expr<P>& e) const
+    {
+        if (hist)
+            return hist->count_if(e);
+        const P& p = e.self();
+        std::ptrdiff_t n = 0;
+        for (std::uint8_t age : bytes)
+            n += p(age);
+        return n;
+    }
+
+    template <typename P>
+    bool none_of(const pred::Expr<P>& e) const
+    {
+        if (hist)
+            return hist->none_of(e);
+        return find_if(e) == end();
+    }
+
+    template <typename P>
+    bool all_of(const pred::Expr<P>& e) const { return none_of(!e); }
+
+    const_iterator find(int age) const
+    {
+        if (!fits(age))
+            return end();
+        return find_if(pred::x == age);
+    }
+
+    template <typename P>
+    const_iterator find_if(const pred::Expr<P>& e) const
+    {
+        const P& p = e.self();
+        const std::uint8_t* first = bytes.data();
+        const std::uint8_t* last = first + bytes.size();
+        constexpr std::ptrdiff_t BLOCK = 256;
+        while (last - first >= BLOCK) {
+            bool any = false;
+            for (std::ptrdiff_t i = 0; i < BLOCK; i++)
+                any |= p(first[i]);
+            if (any)
+                break;
+            first += BLOCK;
+        }
+        for (; first != last; ++first)
+            if (p(*first))
+                break;
+        return const_iterator(first);
+    }
+
+    // two columns are equal when they hold the same ages - the histogram does not matter
+    bool operator==(const AgeColumn& other) const { return bytes == other.bytes; }
+    auto operator<=>(const AgeColumn& other) const { return bytes <=> other.bytes; }
+
+private:
+    std::vector<std::uint8_t>::const_iterator to_vector_iterator(const_iterator it) const
+    {
+        return bytes.cbegin() + (it.base() - bytes.data());
+    }
+    const_iterator make_iterator(std::vector<std::uint8_t>::iterator it) const
+    {
+        return const_iterator(bytes.data() + (it - bytes.begin()));
+    }
+
+    std::vector<std::uint8_t> bytes;
+    std::optional<AgeHistogram> hist;
+};
+
+#endif //SAM206_AGE_COLUMN_H
@@ -0,0 +1,162 @@
+// age_histogram - how many students there are of each age
+//
+// https://en.cppreference.com/w/cpp/container/array
+
+#ifndef SAM206_AGE_HISTOGRAM_H
+#define SAM206_AGE_HISTOGRAM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include "predicate.h"
+
+/**
+ *  AgeHistogram
+ *  Keeps one counter ("bin") for every possible age 0..255.  After each
+ *  add() or remove() the bins hold exactly how many times each age occurs,
+ *  so queries do not need to look at the ages themselves:
+ *      count(21)                       one array lookup      O(1)
+ *      min() / max()                   first / last age present   O(1)
+ *      all_of / none_of                O(1) for an interval predicate
+ *      count_less(18)                  add up bins 0..17     O(range)
+ *      count_if                        add up the bins the predicate accepts   O(range)
+ *  O(range) means the work depends on the number of possible ages (256),
+ *  not on the number of students - it is the same for 5 or 500 million.
+ *
+ *  Besides the bins, one bit per age records whether that age is present
+ *  (4 words of 64 bits).  The lowest set bit is min(), the highest is
+ *  max(), and a few masked words answer "is any age in 17..29 present?".
+ *  So when the predicate is an interval (see pred::range_of),
+ *      all_of(x > 16)      is  min() > 16
+ *      none_of(x < 17)     is  min() >= 17
+ *  and other predicates, such as mod<2> == 0, visit the 256 bins.
+ */
+class AgeHistogram {
+public:
+    static constexpr int BINS = 256;
+
+    void add(int age)
+    {
+        if (bins[age]++ == 0)
+            present[age / 64] |= bit(age);
+        ++total;
+    }
+    void remove(int age)
+    {
+        if (--bins[age] == 0)
+            present[age / 64] &= ~bit(age);
+        --total;
+    }
+    void clear()
+    {
+        bins.fill(0);
+        present.fill(0);
+        total = 0;
+    }
+
+    std::size_t size() const { return total; }
+    bool empty() const { return total == 0; }
+
+    std::ptrdiff_t count(int age) const
+    {
+        return (age < 0 || age >= BINS) ? 0 : std::ptrdiff_t(bins[age]);
+    }
+
+    // number of ages strictly less than "age"
+    std::ptrdiff_t count_less(int age) const
+    {
+        std::ptrdiff_t n = 0;
+        for (int a = 0; a < BINS && a < age; a++)
+            n += bins[a];
+        return n;
+    }
+
+    // smallest and largest age present - only meaningful when !empty()
+    int min() const
+    {
+        for (int w = 0; w < WORDS; w++)
+            if (present[w] != 0)
+                return w * 64 + __builtin_ctzll(present[w]);
+        return 0;
+    }
+    int max() const
+    {
+        for (int w = WORDS - 1; w >= 0; w--)
+            if (present[w] != 0)
+                return w * 64 + 63 - __builtin_clzll(present[w]);
+        return 0;
+    }
+
+    // Is any age in lo..hi present?  Looks at no more than the 4 words.
+    bool any_between(int lo, int hi) const
+    {
+        lo = lo < 0 ? 0 : lo;
+        hi = hi > BINS - 1 ? BINS - 1 : hi;
+        for (int w = lo / 64; lo <= hi && w <= hi / 64; w++) {
+            std::uint64_t word = present[w];
+            if (w == lo / 64)
+                word &= ~std::uint64_t(0) << (lo % 64);
+            if (w == hi / 64)
+                word &= ~std::uint64_t(0) >> (63 - hi % 64);
+            if (word != 0)
+                return true;
+        }
+        return false;
+    }
+
+    // Every age that occurs is tested once, and counts for all of its students.
+    template <typename P>
+    std::ptrdiff_t count_if(const pred::Expr<P>& e) const
+    {
+        if constexpr (pred::has_range<P>) {
+            if (std::optional<pred::Range> r = pred::range_of(e.self())) {
+                std::ptrdiff_t inside = 0;
+                for (int a = r->lo < 0 ? 0 : r->lo; a < BINS && a <= r->hi; a++)
+                    inside += bins[a];
+                return r->outside ? std::ptrdiff_t(total) - inside : inside;
+            }
+        }
+        const P& p = e.self();
+        std::ptrdiff_t n = 0;
+        for (int a = 0; a < BINS; a++)
+            n += p(a) ? std::ptrdiff_t(bins[a]) : 0;
+        return n;
+    }
+
+    template <typename P>
+    bool none_of(const pred::Expr<P>& e) const
+    {
+        if constexpr (pred::has_range<P>) {
+            if (std::optional<pred::Range> r = pred::range_of(e.self())) {
+                if (empty())
+                    return true;
+                if (r->outside)         // no age outside lo..hi: all of them are inside
+                    return r->lo <= min() && max() <= r->hi;
+                if (r->lo <= 0)         // x < k or x <= k
+                    return min() > r->hi;
+                if (r->hi >= BINS - 1)  // x > k or x >= k
+                    return max() < r->lo;
+                return !any_between(r->lo, r->hi);
+            }
+        }
+        const P& p = e.self();
+        for (int a = 0; a < BINS; a++)
+            if (bins[a] != 0 && p(a))
+                return false;
+        return true;
+    }
+
+    template <typename P>
+    bool all_of(const pred::Expr<P>& e) const { return none_of(!e); }
+
+private:
+    static constexpr int WORDS = BINS / 64;
+    static constexpr std::uint64_t bit(int age) { return std::uint64_t(1) << (age % 64); }
+
+    std::array<std::size_t, BINS> bins{};
+    std::array<std::uint64_t, WORDS> present{};     // bit "age" is set when bins[age] > 0
+    std::size_t total = 0;
+};
+
+#endif //SAM206_AGE_HISTOGRAM_H
@@ -0,0 +1,393 @@
+// age_loader - fill a vector of ages from a text or binary file
+
+#include "age_loader.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// closes the FILE automatically, even when an exception is thrown
+struct FileCloser {
+    void operator()(FILE* f) const { fclose(f); }
+};
+using File = unique_ptr<FILE, FileCloser>;
+
+File open_file(const string& path, const char* mode)
+{
+    File f(fopen(path.c_str(), mode));
+    if (!f)
+        throw runtime_error("cannot open " + path);
+    return f;
+}
+
+size_t file_size(FILE* f, const string& path)
+{
+    if (fseek(f, 0, SEEK_END) != 0)
+        throw runtime_error("cannot seek in " + path);
+    long size = ftell(f);
+    if (size < 0 || fseek(f, 0, SEEK_SET) != 0)
+        throw runtime_error("cannot seek in " + path);
+    return size_t(size);
+}
+
+void read_exactly(FILE* f, void* dest, size_t bytes, const string& path)
+{
+    if (fread(dest, 1, bytes, f) != bytes)
+        throw runtime_error("cannot read " + path);
+}
+
+bool is_separator(char c)
+{
+    return c == ',' || c == '\n' || c == '\r' || c == ' ' || c == '\t';
+}
+
+// Upper bound for the number of values: each value ends at a separator or
+// at the end of the text.
+size_t count_separators(const char* first, const char* last)
+{
+    size_t n = 0;
+    for (const char* p = first; p != last; ++p)
+        n += is_separator(*p);
+    return n;
+}
+
+// Parses the number starting at p (not a separator) into "value".
+// Error messages give the position counted from "first".
+// @return pointer just past the number
+const char* parse_one(const char* first, const char* p, const char* last, int& value)
+{
+    bool negative = (*p == '-');
+    if (negative)
+        ++p;
+    if (p == last || unsigned(*p - '0') > 9)
+        throw runtime_error("not a number at byte " + to_string(p - first));
+
+    int64_t v = 0;
+    while (p != last && unsigned(*p - '0') <= 9) {
+        v = v * 10 + (*p - '0');
+        if (v > int64_t(INT32_MAX) + 1)
+            throw runtime_error("number too large at byte " + to_string(p - first));
+        ++p;
+    }
+    if (negative)
+        v = -v;
+    if (v > INT32_MAX)
+        throw runtime_error("number too large at byte " + to_string(p - first));
+    if (p != last && !is_separator(*p))
+        throw runtime_error("unexpected character at byte " + to_string(p - first));
+    value = int(v);
+    return p;
+}
+
+// Parses the ages in [first, last) into out[0], out[1], ...
+// @return pointer just past the last age written
+int* parse_ages(const char* first, const char* last, int* out)
+{
+    const char* p = first;
+    while (true) {
+        while (p != last && is_separator(*p))
+            ++p;
+        if (p == last)
+            return out;
+        p = parse_one(first, p, last, *out++);
+    }
+}
+
+// The parallel loader reads up to 8 bytes past the end of a chunk, so the
+// text is followed by this many separator bytes
+constexpr size_t PADDING = 16;
+
+// Number of values in [first, last), which starts just after a separator:
+// a value starts wherever a non-separator follows a separator.
+size_t count_values(const char* first, const char* last)
+{
+    size_t n = 0;
+    bool after_separator = true;
+    const char* p = first;
+#ifdef __SSE2__
+    const __m128i comma = _mm_set1_epi8(','), newline = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r'),
+                  space = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t');
+    unsigned carry = 1;
+    for (; last - p >= 16; p += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i sep = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, comma), _mm_cmpeq_epi8(c, newline)),
+                                   _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, cr), _mm_cmpeq_epi8(c, space)),
+                                                _mm_cmpeq_epi8(c, tab)));
+        unsigned is_sep = unsigned(_mm_movemask_epi8(sep));
+        unsigned previous_sep = (is_sep << 1) | carry;     // bit i: byte i-1 is a separator
+        n += unsigned(__builtin_popcount(~is_sep & previous_sep & 0xFFFF));
+        carry = is_sep >> 15;
+    }
+    after_separator = carry != 0;
+#endif
+    for (; p != last; ++p) {
+        bool sep = is_separator(*p);
+        n += !sep && after_separator;
+        after_separator = sep;
+    }
+    return n;
+}
+
+// Like parse_ages(), but converts numbers of 1 to 8 digits in one go.
+// Needs PADDING readable bytes after "last"; anything else (a minus sign,
+// a longer number, an error) is handled by parse_one().  The 8 bytes are
+// read as one little-endian word, so big-endian machines use parse_ages().
+int* parse_ages_swar(const char* first, const char* last, int* out)
+{
+    if constexpr (endian::native == endian::big)
+        return parse_ages(first, last, out);
+
+    constexpr uint64_t ones = 0x0101010101010101ull;
+    const char* p = first;
+    while (true) {
+        while (p != last && is_separator(*p))
+            ++p;
+        if (p == last)
+            return out;
+
+        uint64_t chars;
+        memcpy(&chars, p, 8);
+        uint64_t digits = chars ^ (ones * '0');     // '0'..'9' become 0..9
+        // the top bit of each byte that is not 0..9
+        uint64_t not_digit = (((digits & (ones * 0x7F)) + ones * 0x76) | digits) & (ones * 0x80);
+        size_t len = not_digit ? size_t(__builtin_ctzll(not_digit)) / 8 : 8;
+        // 8 digits are only a whole number if the 9th byte is a separator
+        if (len == 0 || p + len > last || (p + len != last && !is_separator(p[len]))) {
+            p = parse_one(first, p, last, *out++);
+            continue;
+        }
+        // move the digits to the top, so the missing ones become leading zeros,
+        // then combine neighbouring digits: pairs, then fours, then all eight
+        uint64_t v = digits << (8 * (8 - len));
+        v = (v * 10 + (v >> 8)) & 0x00FF00FF00FF00FFull;
+        v = (v * 100 + (v >> 16)) & 0x0000FFFF0000FFFFull;
+        v = (v * 10000 + (v >> 32)) & 0xFFFFFFFFull;
+        *out++ = int(v);
+        p += len;
+    }
+}
+
+double seconds_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+LoadStats load_ages_text(const string& path, vector<int>& vect)
+{
+    auto start = chrono::steady_clock::now();
+    File f = open_file(path, "rb");
+    LoadStats stats;
+    stats.bytes = file_size(f.get(), path);
+
+    vector<char> text(stats.bytes);
+    read_exactly(f.get(), text.data(), text.size(), path);
+
+    const char* first = text.data();
+    const char* last = first + text.size();
+    // make room for the most ages the text could hold, parse straight into
+    // the vector's memory, then shrink it to the number actually parsed
+    vect.clear();
+    vect.resize(count_separators(first, last) + 1);
+    int* end = parse_ages(first, last, vect.data());
+    vect.resize(size_t(end - vect.data()));
+
+    stats.values = vect.size();
+    stats.seconds = seconds_since(start);
+    return stats;
+}
+
+LoadStats load_ages_text_parallel(const string& path, vector<int>& vect, ThreadPool& pool)
+{
+    auto start = chrono::steady_clock::now();
+    File f = open_file(path, "rb");
+    LoadStats stats;
+    stats.bytes = file_size(f.get(), path);
+
+    vector<char> text(stats.bytes + PADDING, '\n');
+    read_exactly(f.get(), text.data(), stats.bytes, path);
+    const char* first = text.data();
+    const char* last = first + stats.bytes;
+
+    // cut the text into chunks that each start just after a separator
+    constexpr size_t MIN_CHUNK = 64 * 1024;
+    size_t chunks = max<size_t>(1, min<size_t>(size_t(pool.size()) * 4, stats.bytes / MIN_CHUNK));
+    vector<const char*> bounds(chunks + 1, last);
+    bounds[0] = first;
+    for (size_t i = 1; i < chunks; i++) {
+        const char* p = max(bounds[i - 1], first + stats.bytes / chunks * i);
+        const char* nl = static_cast<const char*>(memchr(p, '\n', size_t(last - p)));
+        if (nl == nullptr)
+            nl = find_if(p, last, is_separator);
+        bounds[i] = nl == last ? last : nl + 1;
+    }
+
+    vector<size_t> offset(chunks + 1, 0);
+    pool.run(chunks, [&](size_t i) { offset[i + 1] = count_values(bounds[i], bounds[i + 1]); });
+    for (size_t i = 0; i < chunks; i++)
+        offset[i + 1] += offset[i];
+
+    vect.clear();
+    vect.resize(offset[chunks]);
+    try {
+        pool.run(chunks, [&](size_t i) {
+            int* end = parse_ages_swar(bounds[i], bounds[i + 1], vect.data() + offset[i]);
+            if (end != vect.data() + offset[i + 1])
+                throw runtime_error("count mismatch");      // cannot happen for valid text
+        });
+    } catch (const exception&) {
+        // let the sequential parser find the first error, and report it the same way
+        vect.resize(count_separators(first, last) + 1);
+        int* end = parse_ages(first, last, vect.data());
+        vect.resize(size_t(end - vect.data()));
+    }
+
+    stats.values = vect.size();
+    stats.seconds = seconds_since(start);
+    return stats;
+}
+
+LoadStats load_ages_text_async(const string& path, vector<int>& vect, const AsyncReadOptions& options)
+{
+    auto start = chrono::steady_clock::now();
+    File f = open_file(path, "rb");
+    LoadStats stats;
+    stats.bytes = file_size(f.get(), path);
+
+    // The file holds at most bytes / 2 + 1 ages - every age but the last is
+    // followed by a separator - so that much is reserved before the first
+    // block arrives and the vector never moves.  Each piece is then sized by
+    // its own separators, as load_ages_text() sizes the whole text, so only
+    // the ints that can be parsed into are zero-filled.
+    vect.clear();
+    vect.reserve(stats.bytes / 2 + 1);
+    size_t used = 0;
+    auto parse_piece = [&](const char* first, const char* last) {
+        vect.resize(used + count_separators(first, last) + 1);
+        int* end = parse_ages(first, last, vect.data() + used);
+        used = size_t(end - vect.data());
+        vect.resize(used);
+    };
+
+    string carry;   // the start of a number cut off by the end of the previous block
+    try {
+        read_blocks(fileno(f.get()), stats.bytes, nullptr, options,
+                    [&](size_t, const char* data, size_t length) {
+            const char* p = data;
+            const char* last = data + length;
+            if (!carry.empty()) {
+                const char* sep = find_if(p, last, is_separator);
+                carry.append(p, sep);
+                if (sep == last)
+                    return;             // the number goes on into the next block
+                parse_piece(carry.data(), carry.data() + carry.size());
+                carry.clear();
+                p = sep;
+            }
+            const char* cut = last;
+            while (cut != p && !is_separator(cut[-1]))
+                --cut;
+            parse_piece(p, cut);
+            carry.assign(cut, last);
+        });
+        parse_piece(carry.data(), carry.data() + carry.size());
+    } catch (const exception&) {
+        // let the sequential loader report the error, with the same message
+        stats = load_ages_text(path, vect);
+        stats.seconds = seconds_since(start);
+        return stats;
+    }
+    // the reservation is about 1.5 times the ages of a file of two-digit
+    // ages; give the rest back rather than keep it for the vector's lifetime
+    if (vect.capacity() - vect.size() > vect.size() / 8)
+        vect.shrink_to_fit();
+
+    stats.values = vect.size();
+    stats.seconds = seconds_since(start);
+    return stats;
+}
+
+LoadStats load_ages_binary_async(const string& path, vector<int>& vect, const AsyncReadOptions& options)
+{
+    auto start = chrono::steady_clock::now();
+    File f = open_file(path, "rb");
+    LoadStats stats;
+    stats.bytes = file_size(f.get(), path);
+    if (stats.bytes % sizeof(int32_t) != 0)
+        throw runtime_error(path + " is not a whole number of 4-byte ages");
+
+    vect.clear();
+    vect.resize(stats.bytes / sizeof(int32_t));
+    // blocks are whole pages, so each one holds whole ints
+    read_blocks(fileno(f.get()), stats.bytes, reinterpret_cast<char*>(vect.data()), options,
+                [&](size_t offset, const char*, size_t length) {
+        if constexpr (endian::native == endian::big) {
+            for (size_t i = offset / 4; i < (offset + length) / 4; i++)
+                vect[i] = int(__builtin_bswap32(uint32_t(vect[i])));
+        }
+    });
+
+    stats.values = vect.size();
+    stats.seconds = seconds_since(start);
+    return stats;
+}
+
+LoadStats load_ages_binary(const string& path, vector<int>& vect)
+{
+    auto start = chrono::steady_clock::now();
+    File f = open_file(path, "rb");
+    LoadStats stats;
+    stats.bytes = file_size(f.get(), path);
+    if (stats.bytes % sizeof(int32_t) != 0)
+        throw runtime_error(path + " is not a whole number of 4-byte ages");
+
+    vect.clear();
+    vect.resize(stats.bytes / sizeof(int32_t));
+    read_exactly(f.get(), vect.data(), stats.bytes, path);
+    if constexpr (endian::native == endian::big) {
+        for (int& age : vect)
+            age = int(__builtin_bswap32(uint32_t(age)));
+    }
+
+    stats.values = vect.size();
+    stats.seconds = seconds_since(start);
+    return stats;
+}
+
+void save_ages_text(const string& path, const vector<int>& vect)
+{
+    File f = open_file(path, "wb");
+    for (int age : vect)
+        fprintf(f.get(), "%d\n", age);
+    if (ferror(f.get()))
+        throw runtime_error("cannot write " + path);
+}
+
+void save_ages_binary(const string& path, const vector<int>& vect)
+{
+    File f = open_file(path, "wb");
+    if constexpr (endian::native == endian::big) {
+        for (int age : vect) {
+            uint32_t le = __builtin_bswap32(uint32_t(age));
+            fwrite(&le, sizeof le, 1, f.get());
+        }
+    } else {
+        fwrite(vect.data(), sizeof(int32_t), vect.size(), f.get());
+    }
+    if (ferror(f.get()))
+        throw runtime_error("cannot write " + path);
+}
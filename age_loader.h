@@ -0,0 +1,78 @@
+// age_loader - fill a vector of ages from a text or binary file
+//
+// https://en.cppreference.com/w/cpp/io/c/fread
+
+#ifndef SAM206_AGE_LOADER_H
+#define SAM206_AGE_LOADER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "async_reader.h"
+#include "thread_pool.h"
+
+/**
+ *  What a load did, and how fast - used to report throughput.
+ */
+struct LoadStats {
+    std::size_t bytes = 0;      // size of the file
+    std::size_t values = 0;     // number of ages loaded
+    double seconds = 0;         // time taken, including reading the file
+
+    double mb_per_second() const { return seconds > 0 ? bytes / 1e6 / seconds : 0; }
+};
+
+/**
+ *  populate_vector() in main.cpp adds five fixed ages.  These functions
+ *  load the ages from a file instead.  Both clear the vector first, and
+ *  reserve the space for all of the ages before adding any, so the vector
+ *  never has to grow.  They throw runtime_error if the file cannot be read
+ *  or is not valid.
+ *
+ *  load_ages_text() reads ages separated by commas, spaces and/or newlines,
+ *  e.g. "18,17,21\n18,21\n".  Numbers are parsed by a simple hand-written
+ *  loop - much faster than "file >> age" with an input stream.
+ *
+ *  load_ages_binary() reads a file of 4-byte little-endian ints, the format
+ *  that save_ages_binary() writes.
+ */
+LoadStats load_ages_text(const std::string& path, std::vector<int>& vect);
+LoadStats load_ages_binary(const std::string& path, std::vector<int>& vect);
+
+/**
+ *  load_ages_text_parallel() gives exactly the same result as
+ *  load_ages_text(), using every thread of the pool.  The text is cut into
+ *  chunks just after a newline (or, for one long line, just after a comma
+ *  or space), so no number is split between two chunks.  Then:
+ *      1. each thread counts the numbers in its chunks - 16 bytes at a time
+ *         with SIMD compares
+ *      2. adding up the counts tells each chunk where its ages go, so the
+ *         vector is sized once and each chunk is parsed straight into its
+ *         own part of it - the ages stay in file order
+ *  Numbers of up to 8 digits are converted 8 characters at a time (SWAR -
+ *  SIMD within a 64-bit register).  If the text has an error, the file is
+ *  parsed again by the sequential code, so the same exception is thrown.
+ */
+LoadStats load_ages_text_parallel(const std::string& path, std::vector<int>& vect,
+                                  ThreadPool& pool = ThreadPool::shared());
+
+/**
+ *  The _async versions read the file through read_blocks() (see
+ *  async_reader.h), with several large reads in flight at once, so the
+ *  reading overlaps with the work on the blocks that have already arrived.
+ *  load_ages_text_async() parses each block as soon as it arrives; a number
+ *  cut in two by the end of a block is finished with the next block.
+ *  load_ages_binary_async() reads the blocks straight into the vector.
+ *  The results (and exceptions for invalid text) are the same as for
+ *  load_ages_text() and load_ages_binary().
+ */
+LoadStats load_ages_text_async(const std::string& path, std::vector<int>& vect,
+                               const AsyncReadOptions& options = {});
+LoadStats load_ages_binary_async(const std::string& path, std::vector<int>& vect,
+                                 const AsyncReadOptions& options = {});
+
+// Write the ages as "18\n17\n..." or as 4-byte little-endian ints
+void save_ages_text(const std::string& path, const std::vector<int>& vect);
+void save_ages_binary(const std::string& path, const std::vector<int>& vect);
+
+#endif //SAM206_AGE_LOADER_H
@@ -0,0 +1,148 @@
+// allocators - a monotonic arena and a size-class pool
+
+#include "allocators.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <new>
+
+using namespace std;
+
+MonotonicArena::MonotonicArena(size_t initial_bytes, pmr::memory_resource* upstream)
+    : upstream(upstream), next_chunk_size(max(initial_bytes, size_t(256)))
+{
+}
+
+MonotonicArena::~MonotonicArena()
+{
+    release();
+}
+
+void MonotonicArena::add_chunk(size_t size)
+{
+    void* raw = upstream->allocate(size, alignof(max_align_t));
+    ++counts.upstream_allocations;
+    counts.upstream_bytes += size;
+    chunks = ::new (raw) Chunk{chunks, size};
+    current = static_cast<char*>(raw) + sizeof(Chunk);
+    limit = static_cast<char*>(raw) + size;
+}
+
+void* MonotonicArena::do_allocate(size_t bytes, size_t alignment)
+{
+    ++counts.allocations;
+    counts.bytes_requested += bytes;
+
+    uintptr_t p = (uintptr_t(current) + alignment - 1) & ~uintptr_t(alignment - 1);
+    if (current == nullptr || p + bytes > uintptr_t(limit)) {
+        // the next chunk is twice as big, so the number of chunks grows only as log(total)
+        size_t size = max(next_chunk_size, sizeof(Chunk) + bytes + alignment);
+        next_chunk_size = size * 2;
+        add_chunk(size);
+        p = (uintptr_t(current) + alignment - 1) & ~uintptr_t(alignment - 1);
+    }
+    current = reinterpret_cast<char*>(p + bytes);
+    return reinterpret_cast<void*>(p);
+}
+
+void MonotonicArena::reset()
+{
+    if (chunks == nullptr)
+        return;
+    if (chunks->next != nullptr) {
+        // swap all the chunks for one that holds as much as they did together
+        size_t total = 0;
+        for (Chunk* c = chunks; c != nullptr; c = c->next)
+            total += c->size;
+        release();
+        add_chunk(total);
+        next_chunk_size = total * 2;
+    }
+    current = reinterpret_cast<char*>(chunks) + sizeof(Chunk);
+}
+
+void MonotonicArena::release()
+{
+    while (chunks != nullptr) {
+        Chunk* next = chunks->next;
+        upstream->deallocate(chunks, chunks->size, alignof(max_align_t));
+        chunks = next;
+    }
+    current = limit = nullptr;
+}
+
+size_t MonotonicArena::bytes_in_use() const
+{
+    size_t used = 0;
+    for (Chunk* c = chunks; c != nullptr; c = c->next)
+        used += c->size - sizeof(Chunk);
+    // the newest chunk is only used up to "current"
+    return chunks ? used - size_t(limit - current) : 0;
+}
+
+namespace {
+// 16 -> class 0, 17..32 -> class 1, ... 4096 -> class 8
+size_t size_class(size_t size)
+{
+    return size_t(bit_width(size - 1)) - 4;
+}
+}
+
+SizeClassPool::~SizeClassPool()
+{
+    release();
+}
+
+void* SizeClassPool::do_allocate(size_t bytes, size_t alignment)
+{
+    ++counts.allocations;
+    counts.bytes_requested += bytes;
+
+    // a block of size 2^k is aligned to 2^k, so alignment just raises the size
+    size_t size = max({bytes, alignment, MIN_CLASS});
+    if (size > MAX_CLASS) {
+        ++counts.upstream_allocations;
+        counts.upstream_bytes += bytes;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    size_t k = size_class(size);
+    SizeClass& c = classes[k];
+    if (c.free != nullptr) {
+        FreeBlock* block = c.free;
+        c.free = block->next;
+        return block;
+    }
+    if (c.current == c.limit) {
+        void* slab = upstream->allocate(SLAB, MAX_CLASS);
+        ++counts.upstream_allocations;
+        counts.upstream_bytes += SLAB;
+        slabs.push_back(slab);
+        c.current = static_cast<char*>(slab);
+        c.limit = c.current + SLAB;
+    }
+    void* block = c.current;
+    c.current += MIN_CLASS << k;
+    return block;
+}
+
+void SizeClassPool::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+    ++counts.deallocations;
+    size_t size = max({bytes, alignment, MIN_CLASS});
+    if (size > MAX_CLASS) {
+        upstream->deallocate(p, bytes, alignment);
+        return;
+    }
+    SizeClass& c = classes[size_class(size)];
+    c.free = ::new (p) FreeBlock{c.free};
+}
+
+void SizeClassPool::release()
+{
+    for (void* slab : slabs)
+        upstream->deallocate(slab, SLAB, MAX_CLASS);
+    slabs.clear();
+    classes = {};
+}
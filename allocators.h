@@ -0,0 +1,172 @@
+// allocators - a monotonic arena and a size-class pool, for vectors that are
+// filled and thrown away over and over
+//
+// https://en.cppreference.com/w/cpp/memory/memory_resource
+
+#ifndef SAM206_ALLOCATORS_H
+#define SAM206_ALLOCATORS_H
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/**
+ *  Where does a vector's memory come from?
+ *  Every time a vector grows it asks its allocator for a bigger block; the
+ *  default allocator asks the global heap (operator new / malloc), which
+ *  has to find a free block, may take a lock, and has to be given it back.
+ *  A program that builds and discards millions of small vectors spends much
+ *  of its time there.  The two memory resources below get large blocks from
+ *  the heap once, and then hand out pieces of them very cheaply.
+ *
+ *  Both work through std::pmr:
+ *      MonotonicArena arena;
+ *      std::pmr::vector<int> ages(&arena);
+ *  or as the allocator parameter of an ordinary vector (see ResourceAllocator):
+ *      arena_vector<int> ages{ResourceAllocator<int, MonotonicArena>(arena)};
+ *
+ *  Neither is thread safe - use one per thread.
+ */
+
+// Counters kept by each memory resource
+struct AllocationStats {
+    std::size_t allocations = 0;            // allocate() calls
+    std::size_t deallocations = 0;          // deallocate() calls
+    std::size_t bytes_requested = 0;        // total size of the allocate() calls
+    std::size_t upstream_allocations = 0;   // blocks taken from the heap (or other upstream resource)
+    std::size_t upstream_bytes = 0;
+};
+
+/**
+ *  MonotonicArena
+ *  Hands out memory by moving a pointer forward through a large chunk - an
+ *  allocation is an addition and a comparison.  deallocate() does nothing:
+ *  the memory comes back all at once when reset() is called, e.g. at the
+ *  end of each populate / display / query cycle.
+ *
+ *  When a chunk is full a bigger one (twice the size) is taken from the
+ *  upstream resource.  reset() replaces several chunks by one large enough
+ *  for all of them, so the next cycle of the same size takes nothing from
+ *  the heap at all.
+ */
+class MonotonicArena final : public std::pmr::memory_resource {
+public:
+    static constexpr std::size_t DEFAULT_CHUNK = 64 * 1024;
+
+    explicit MonotonicArena(std::size_t initial_bytes = DEFAULT_CHUNK,
+                            std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    ~MonotonicArena() override;
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    // Forget everything handed out, keeping the memory for the next cycle
+    void reset();
+    // Give all memory back to the upstream resource
+    void release();
+
+    std::size_t bytes_in_use() const;
+    const AllocationStats& stats() const { return counts; }
+
+private:
+    struct Chunk {
+        Chunk* next;
+        std::size_t size;       // including this header
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void*, std::size_t, std::size_t) override { ++counts.deallocations; }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void add_chunk(std::size_t at_least);
+
+    std::pmr::memory_resource* upstream;
+    Chunk* chunks = nullptr;    // newest first
+    char* current = nullptr;    // next free byte in the newest chunk
+    char* limit = nullptr;      // end of the newest chunk
+    std::size_t next_chunk_size;
+    AllocationStats counts;
+};
+
+/**
+ *  SizeClassPool
+ *  Rounds each request up to a "size class" - 16, 32, 64 ... 4096 bytes -
+ *  and keeps a free list for each class.  A freed block goes on the front
+ *  of its list, and the next request of that class takes it straight back:
+ *  no searching, and memory really is reused, unlike the arena.  Blocks are
+ *  cut from 64 KB slabs taken from upstream; requests over 4096 bytes go
+ *  straight to upstream.
+ */
+class SizeClassPool final : public std::pmr::memory_resource {
+public:
+    static constexpr std::size_t MIN_CLASS = 16;
+    static constexpr std::size_t MAX_CLASS = 4096;
+    static constexpr std::size_t CLASSES = 9;           // 16, 32, ... 4096
+    static constexpr std::size_t SLAB = 64 * 1024;
+
+    explicit SizeClassPool(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream(upstream) {}
+    ~SizeClassPool() override;
+
+    SizeClassPool(const SizeClassPool&) = delete;
+    SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+    // Give all slabs back to the upstream resource - every block must be freed first
+    void release();
+
+    const AllocationStats& stats() const { return counts; }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    struct SizeClass {
+        FreeBlock* free = nullptr;
+        char* current = nullptr;    // uncut part of this class's newest slab
+        char* limit = nullptr;
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    std::pmr::memory_resource* upstream;
+    std::array<SizeClass, CLASSES> classes{};
+    std::vector<void*> slabs;
+    AllocationStats counts;
+};
+
+/**
+ *  ResourceAllocator
+ *  An allocator for the second template parameter of vector (or any other
+ *  container), drawing from one MonotonicArena or SizeClassPool.  Unlike
+ *  std::pmr::polymorphic_allocator it knows the exact resource type, so
+ *  the compiler can call it directly instead of through a virtual function.
+ */
+template <typename T, typename Resource>
+class ResourceAllocator {
+public:
+    using value_type = T;
+
+    explicit ResourceAllocator(Resource& resource) noexcept : resource(&resource) {}
+    template <typename U>
+    ResourceAllocator(const ResourceAllocator<U, Resource>& other) noexcept : resource(other.resource) {}
+
+    T* allocate(std::size_t n) { return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T* p, std::size_t n) noexcept { resource->deallocate(p, n * sizeof(T), alignof(T)); }
+
+    friend bool operator==(const ResourceAllocator& a, const ResourceAllocator& b) { return a.resource == b.resource; }
+
+private:
+    template <typename, typename> friend class ResourceAllocator;
+    Resource* resource;
+};
+
+template <typename T>
+using arena_vector = std::vector<T, ResourceAllocator<T, MonotonicArena>>;
+
+template <typename T>
+using pool_vector = std::vector<T, ResourceAllocator<T, SizeClassPool>>;
+
+#endif //SAM206_ALLOCATORS_H
@@ -0,0 +1,357 @@
+// async_reader - read a file in large blocks, with several reads in flight
+
+#include "async_reader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define SAM206_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+runtime_error read_error(int error)
+{
+    return runtime_error(string("read failed: ") + strerror(error));
+}
+
+/*
+ * Which bytes each block covers, and where it is read to.  Block k is
+ * bytes [k * block_size, ...) of the file; it uses buffer slot k % depth.
+ */
+class Blocks {
+public:
+    Blocks(size_t size, char* dest, const AsyncReadOptions& options)
+        : size(size), dest(dest), depth(max(1u, options.depth))
+    {
+        // whole pages, and small enough for one read() result (an int)
+        block_size = min<size_t>(max<size_t>(options.block_size, 4096) / 4096 * 4096, size_t(1) << 30);
+        if (dest == nullptr)
+            buffers.resize(min(size, block_size * depth));
+    }
+
+    size_t count() const { return (size + block_size - 1) / block_size; }
+    size_t offset(size_t k) const { return k * block_size; }
+    size_t length(size_t k) const { return min(block_size, size - offset(k)); }
+    unsigned slot(size_t k) const { return unsigned(k % depth); }
+    char* data(size_t k) { return dest ? dest + offset(k) : buffers.data() + size_t(slot(k)) * block_size; }
+
+    size_t size;
+    char* dest;
+    unsigned depth;
+    size_t block_size;
+    vector<char> buffers;
+};
+
+using BlockFn = function<void(size_t, const char*, size_t)>;
+
+// The fallback: a helper thread reads the blocks in order with pread(),
+// at most "depth" blocks ahead of the caller, who runs on_block().
+void read_with_thread(int fd, Blocks& blocks, const BlockFn& on_block)
+{
+    const size_t n = blocks.count();
+    mutex m;
+    condition_variable changed;
+    size_t read_count = 0;          // blocks 0 .. read_count-1 have been read
+    size_t released = 0;            // blocks 0 .. released-1 have been handed to on_block
+    bool stop = false;
+    exception_ptr error;
+
+    thread reader([&] {
+        for (size_t k = 0; k < n; k++) {
+            {
+                unique_lock<mutex> lock(m);
+                changed.wait(lock, [&] { return stop || k < released + blocks.depth; });
+                if (stop)
+                    return;
+            }
+            char* p = blocks.data(k);
+            size_t done = 0, len = blocks.length(k);
+            while (done < len) {
+                ssize_t r = pread(fd, p + done, len - done, off_t(blocks.offset(k) + done));
+                if (r < 0 && errno == EINTR)
+                    continue;
+                if (r <= 0) {
+                    lock_guard<mutex> lock(m);
+                    error = make_exception_ptr(r < 0 ? read_error(errno) : runtime_error("file is shorter than expected"));
+                    changed.notify_all();
+                    return;
+                }
+                done += size_t(r);
+            }
+            lock_guard<mutex> lock(m);
+            read_count = k + 1;
+            changed.notify_all();
+        }
+    });
+
+    try {
+        for (size_t k = 0; k < n; k++) {
+            {
+                unique_lock<mutex> lock(m);
+                changed.wait(lock, [&] { return error || k < read_count; });
+                if (error)
+                    rethrow_exception(error);
+            }
+            on_block(blocks.offset(k), blocks.data(k), blocks.length(k));
+            lock_guard<mutex> lock(m);
+            released = k + 1;
+            changed.notify_all();
+        }
+    } catch (...) {
+        {
+            lock_guard<mutex> lock(m);
+            stop = true;
+            changed.notify_all();
+        }
+        reader.join();
+        throw;
+    }
+    reader.join();
+}
+
+#ifdef SAM206_IO_URING
+
+/*
+ * A minimal io_uring: the submission queue (SQ) and completion queue (CQ)
+ * are rings in memory shared with the kernel, mapped with mmap().  We
+ * write a request into the SQ and move its tail; the kernel writes each
+ * result into the CQ and moves its tail; we read it and move the head.
+ * The heads and tails are shared with the kernel, so they are read and
+ * written with acquire/release atomics.
+ */
+class IoUring {
+public:
+    explicit IoUring(unsigned entries)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof params);
+        ring_fd = int(syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_fd < 0)
+            return;
+
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single)
+            sq_size = cq_size = max(sq_size, cq_size);
+        sq_ring = map(sq_size, IORING_OFF_SQ_RING);
+        cq_ring = single ? sq_ring : map(cq_size, IORING_OFF_CQ_RING);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(map(sqes_size, IORING_OFF_SQES));
+        if (sq_ring == nullptr || cq_ring == nullptr || sqes == nullptr) {
+            unmap();
+            return;
+        }
+
+        char* sq = static_cast<char*>(sq_ring);
+        sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cq_ring);
+        cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    ~IoUring() { unmap(); }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool ok() const { return sqes != nullptr; }
+
+    // Queue a readv() of one buffer - readv works on every io_uring kernel
+    void queue_read(int fd, const iovec* iov, uint64_t offset, uint64_t user_data)
+    {
+        unsigned tail = *sq_tail;       // only we write the SQ tail
+        unsigned index = tail & sq_mask;
+        io_uring_sqe& sqe = sqes[index];
+        memset(&sqe, 0, sizeof sqe);
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(iov);
+        sqe.len = 1;
+        sqe.off = offset;
+        sqe.user_data = user_data;
+        sq_array[index] = index;
+        atomic_ref<unsigned>(*sq_tail).store(tail + 1, memory_order_release);
+        ++unsubmitted;
+    }
+
+    // Hand the queued requests to the kernel; wait until at least min_complete have finished
+    void submit(unsigned min_complete)
+    {
+        while (true) {
+            long r = syscall(__NR_io_uring_enter, ring_fd, unsubmitted, min_complete,
+                             min_complete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (r >= 0) {
+                unsubmitted -= unsigned(r);
+                return;
+            }
+            if (errno != EINTR)
+                throw read_error(errno);
+        }
+    }
+
+    bool pop(io_uring_cqe& cqe)
+    {
+        unsigned head = *cq_head;
+        if (head == atomic_ref<unsigned>(*cq_tail).load(memory_order_acquire))
+            return false;
+        cqe = cqes[head & cq_mask];
+        atomic_ref<unsigned>(*cq_head).store(head + 1, memory_order_release);
+        return true;
+    }
+
+private:
+    void* map(size_t size, off_t what)
+    {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, what);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    void unmap()
+    {
+        if (sqes)
+            munmap(sqes, sqes_size);
+        if (cq_ring && cq_ring != sq_ring)
+            munmap(cq_ring, cq_size);
+        if (sq_ring)
+            munmap(sq_ring, sq_size);
+        if (ring_fd >= 0)
+            close(ring_fd);
+        sqes = nullptr;
+        sq_ring = cq_ring = nullptr;
+        ring_fd = -1;
+    }
+
+    int ring_fd = -1;
+    void* sq_ring = nullptr;
+    void* cq_ring = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    size_t sq_size = 0, cq_size = 0, sqes_size = 0;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned sq_mask = 0;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    io_uring_cqe* cqes = nullptr;
+    unsigned unsubmitted = 0;
+};
+
+void read_with_io_uring(int fd, IoUring& ring, Blocks& blocks, const BlockFn& on_block)
+{
+    const size_t n = blocks.count();
+    vector<iovec> iov(blocks.depth);
+    vector<size_t> done(blocks.depth, 0);       // bytes of the slot's block read so far
+    vector<char> ready(blocks.depth, 0);
+    unsigned in_flight = 0;
+
+    // (re)queue the unread part of block k
+    auto queue = [&](size_t k) {
+        unsigned s = blocks.slot(k);
+        iov[s].iov_base = blocks.data(k) + done[s];
+        iov[s].iov_len = blocks.length(k) - done[s];
+        ring.queue_read(fd, &iov[s], blocks.offset(k) + done[s], k);
+        ++in_flight;
+    };
+    // take every finished read off the completion queue
+    auto collect = [&] {
+        io_uring_cqe cqe;
+        while (ring.pop(cqe)) {
+            --in_flight;
+            size_t k = size_t(cqe.user_data);
+            unsigned s = blocks.slot(k);
+            if (cqe.res < 0)
+                throw read_error(-cqe.res);
+            if (cqe.res == 0)
+                throw runtime_error("file is shorter than expected");
+            done[s] += size_t(cqe.res);
+            if (done[s] < blocks.length(k))
+                queue(k);               // a short read - ask for the rest
+            else
+                ready[s] = 1;
+        }
+    };
+
+    size_t next_queue = 0;
+    try {
+        for (; next_queue < n && next_queue < blocks.depth; next_queue++)
+            queue(next_queue);
+        for (size_t k = 0; k < n; k++) {
+            unsigned s = blocks.slot(k);
+            while (!ready[s]) {
+                ring.submit(1);
+                collect();
+            }
+            on_block(blocks.offset(k), blocks.data(k), blocks.length(k));
+            ready[s] = 0;
+            done[s] = 0;
+            if (next_queue < n)
+                queue(next_queue++);
+        }
+    } catch (...) {
+        // the kernel may still be writing into our buffers - wait for it
+        try {
+            while (in_flight > 0) {
+                ring.submit(1);
+                io_uring_cqe cqe;
+                while (ring.pop(cqe))
+                    --in_flight;
+            }
+        } catch (...) {
+        }
+        throw;
+    }
+}
+
+#endif // SAM206_IO_URING
+
+} // namespace
+
+const char* async_read_method()
+{
+#ifdef SAM206_IO_URING
+    static const bool works = IoUring(1).ok();
+    if (works)
+        return "io_uring";
+#endif
+    return "pread thread";
+}
+
+const char* read_blocks(int fd, size_t size, char* dest, const AsyncReadOptions& options, const BlockFn& on_block)
+{
+    Blocks blocks(size, dest, options);
+#ifdef SAM206_IO_URING
+    if (options.allow_io_uring) {
+        IoUring ring(blocks.depth);
+        if (ring.ok()) {
+            read_with_io_uring(fd, ring, blocks, on_block);
+            return "io_uring";
+        }
+    }
+#endif
+    read_with_thread(fd, blocks, on_block);
+    return "pread thread";
+}
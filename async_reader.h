@@ -0,0 +1,50 @@
+// async_reader - read a file in large blocks, with several reads in flight
+//
+// https://man7.org/linux/man-pages/man7/io_uring.7.html
+
+#ifndef SAM206_ASYNC_READER_H
+#define SAM206_ASYNC_READER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+/**
+ *  Asynchronous reading
+ *  read() stops the program until the data has arrived, so the CPU waits
+ *  for the disk and then the disk waits for the CPU.  read_blocks() asks
+ *  for several blocks at once, and hands each block to on_block() as soon
+ *  as it - and every block before it - has arrived.  While on_block() is
+ *  parsing or copying one block, the next ones are already being read.
+ *
+ *  On Linux the reads go through io_uring: the requests are written into
+ *  a queue shared with the kernel, and the results come back through a
+ *  second one.  Where io_uring is not available (older kernels, containers
+ *  that block it, other systems) a helper thread calls pread() instead,
+ *  which overlaps in the same way.
+ */
+struct AsyncReadOptions {
+    std::size_t block_size = 1 << 20;   // bytes per read
+    unsigned depth = 4;                 // reads in flight at once
+    bool allow_io_uring = true;         // false forces the pread thread
+};
+
+/**
+ * Reads bytes [0, size) of the file open as fd, and calls
+ * on_block(offset, data, length) for each block in file order.
+ *
+ * If dest is not null the blocks are read straight into dest[0 .. size),
+ * and data points into it.  Otherwise they are read into depth buffers of
+ * block_size bytes that are reused, so data is only valid until on_block
+ * returns.  Throws runtime_error if a read fails or the file is shorter
+ * than size; exceptions from on_block are passed on.
+ *
+ * @return the method used: "io_uring" or "pread thread"
+ */
+const char* read_blocks(int fd, std::size_t size, char* dest, const AsyncReadOptions& options,
+                        const std::function<void(std::size_t, const char*, std::size_t)>& on_block);
+
+// "io_uring" if this system lets us use it, otherwise "pread thread"
+const char* async_read_method();
+
+#endif //SAM206_ASYNC_READER_H
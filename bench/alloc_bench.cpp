@@ -0,0 +1,151 @@
+// alloc_bench - builds, displays, queries and throws away many small age
+// vectors, counting the calls to the global heap (operator new)
+//
+// usage:  alloc_bench [number_of_cycles] [ages_per_vector]
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <streambuf>
+#include <vector>
+#include "../allocators.h"
+#include "../count_equal.h"
+#include "../output_buffer.h"
+#include "../predicate.h"
+using namespace std;
+
+// Every allocation of the whole program goes through these, so they can be counted
+static size_t global_allocations = 0;
+
+void* operator new(size_t size)
+{
+    ++global_allocations;
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+void* operator new(size_t size, align_val_t align)
+{
+    ++global_allocations;
+    size_t a = size_t(align);
+    if (void* p = aligned_alloc(a, (size + a - 1) / a * a))
+        return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, align_val_t) noexcept { free(p); }
+
+namespace {
+
+class NullBuffer : public streambuf {
+protected:
+    int_type overflow(int_type c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+// populate_vector() from main.cpp, for any kind of vector, and any number of ages
+template <typename Vector>
+void populate(Vector& vect, size_t ages)
+{
+    static const int main_ages[] = {18, 17, 21, 18, 21};
+    vect.clear();
+    for (size_t i = 0; i < ages; i++)
+        vect.push_back(main_ages[i % 5]);
+}
+
+// display + two queries; returns something so the work is not optimised away
+template <typename Vector>
+long long use(const Vector& vect, OutputBuffer& out)
+{
+    out.write_list(vect.data(), vect.data() + vect.size());
+    return count_equal(vect.data(), vect.data() + vect.size(), 21)
+           + pred::count_if(vect.data(), vect.data() + vect.size(), pred::x < 18);
+}
+
+struct Result {
+    double seconds;
+    size_t heap_allocations;
+    long long checksum;
+};
+
+template <typename Cycle>
+Result run(size_t cycles, Cycle cycle)
+{
+    size_t before = global_allocations;
+    long long checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < cycles; i++)
+        checksum += cycle();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return {elapsed.count(), global_allocations - before, checksum};
+}
+
+void report(const char* name, const Result& r, size_t cycles, const AllocationStats* stats)
+{
+    cout << left << setw(34) << name << right << setw(10) << r.seconds * 1e9 / double(cycles)
+         << setw(14) << r.heap_allocations;
+    if (stats)
+        cout << setw(14) << stats->allocations << setw(12) << stats->upstream_allocations;
+    else
+        cout << setw(14) << "-" << setw(12) << "-";
+    cout << '\n';
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t cycles = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1'000'000;
+    size_t ages = argc > 2 ? strtoull(argv[2], nullptr, 10) : 5;
+
+    NullBuffer null_buffer;
+    ostream null_stream(&null_buffer);
+    OutputBuffer out(null_stream, FlushPolicy::EveryLine);
+
+    // 1. a new std::vector for each cycle, as a service building and discarding vectors would
+    Result plain = run(cycles, [&] {
+        vector<int> v;
+        populate(v, ages);
+        return use(v, out);
+    });
+
+    // 2. std::pmr::vector on an arena that is reset after each cycle
+    MonotonicArena arena;
+    Result arena_result = run(cycles, [&] {
+        long long r;
+        {
+            pmr::vector<int> v(&arena);
+            populate(v, ages);
+            r = use(v, out);
+        }
+        arena.reset();
+        return r;
+    });
+
+    // 3. vector with the pool as its allocator parameter - freed blocks are reused
+    SizeClassPool pool;
+    Result pool_result = run(cycles, [&] {
+        pool_vector<int> v{ResourceAllocator<int, SizeClassPool>(pool)};
+        populate(v, ages);
+        return use(v, out);
+    });
+
+    cout << cycles << " cycles of populate (" << ages << " ages) / display / count / count_if\n\n";
+    cout << fixed << setprecision(1);
+    cout << left << setw(34) << "vector" << right << setw(10) << "ns/cycle" << setw(14) << "heap allocs"
+         << setw(14) << "allocations" << setw(12) << "from heap" << '\n';
+    report("std::vector", plain, cycles, nullptr);
+    report("pmr::vector + MonotonicArena", arena_result, cycles, &arena.stats());
+    report("pool_vector (SizeClassPool)", pool_result, cycles, &pool.stats());
+
+    if (plain.checksum != arena_result.checksum || plain.checksum != pool_result.checksum) {
+        cout << "MISMATCH between the results" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+// bench_harness - time an operation many times and summarise the results
+//
+// https://en.cppreference.com/w/cpp/chrono/steady_clock
+
+#ifndef SAM206_BENCH_HARNESS_H
+#define SAM206_BENCH_HARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+/**
+ *  The numbers reported for one operation on one input:
+ *      median_ns       the typical time of one call
+ *      p99_ns          99% of calls were at least this fast - shows the slow outliers
+ *      ns_per_element  median_ns divided by the number of elements
+ */
+struct Timing {
+    double median_ns = 0;
+    double p99_ns = 0;
+    double ns_per_element = 0;
+};
+
+struct BenchOptions {
+    int warmup = 3;                         // untimed runs first - fills caches, faults in pages
+    int repetitions = 21;                   // timed samples
+    double min_sample_seconds = 20e-6;      // batch calls together until a sample takes this long
+    std::size_t max_batch_elements = 1 << 24;   // limit on batch * elements of prepared copies
+};
+
+// Stops the compiler from throwing away a result that is never used
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Time op(state) and return its median / p99.
+ *
+ * Some operations change their input (pop_back, erase ...), so each call
+ * gets a fresh state from prepare(), made before the clock starts.  For
+ * operations that only read, prepare() can return anything small.
+ *
+ * A single call on 10 elements takes a few nanoseconds - less than the
+ * clock can measure - so small calls are timed in batches: one sample
+ * runs op() on "batch" prepared states and divides the time by batch.
+ */
+template <typename Prepare, typename Op>
+Timing measure(std::size_t elements, const BenchOptions& options, Prepare prepare, Op op)
+{
+    using Clock = std::chrono::steady_clock;
+    using State = decltype(prepare());
+
+    auto run_batch = [&](std::size_t batch) {
+        std::vector<State> states;
+        states.reserve(batch);
+        for (std::size_t i = 0; i < batch; i++)
+            states.push_back(prepare());
+        auto start = Clock::now();
+        for (State& s : states)
+            op(s);
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        return elapsed.count();
+    };
+
+    for (int i = 0; i < options.warmup; i++)
+        run_batch(1);
+
+    // double the batch until one sample is long enough to time accurately
+    std::size_t max_batch = std::max<std::size_t>(1, options.max_batch_elements / std::max<std::size_t>(1, elements));
+    std::size_t batch = 1;
+    while (batch < max_batch && run_batch(batch) < options.min_sample_seconds)
+        batch *= 2;
+
+    std::vector<double> samples;
+    for (int r = 0; r < options.repetitions; r++)
+        samples.push_back(run_batch(batch) * 1e9 / double(batch));
+    std::sort(samples.begin(), samples.end());
+
+    Timing t;
+    t.median_ns = samples[samples.size() / 2];
+    t.p99_ns = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    t.ns_per_element = elements ? t.median_ns / double(elements) : 0;
+    return t;
+}
+
+/**
+ * measure() for an op() that only reads one large input, in seconds:
+ * one warm-up run, then the median of "repetitions" timed runs.
+ */
+template <typename Op>
+double median_seconds(std::size_t elements, int repetitions, Op op)
+{
+    BenchOptions options;
+    options.warmup = 1;
+    options.repetitions = std::max(1, repetitions);
+    return measure(elements, options, [] { return 0; }, [&](int) { op(); }).median_ns * 1e-9;
+}
+
+#endif //SAM206_BENCH_HARNESS_H
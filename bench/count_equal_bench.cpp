@@ -0,0 +1,45 @@
+// count_equal_bench - compares std::count() with the SIMD count_equal()
+//
+// usage:  count_equal_bench [number_of_elements] [repetitions]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../count_equal.h"
+#include "bench_harness.h"
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 50'000'000;
+    int reps = argc > 2 ? atoi(argv[2]) : 5;
+
+    // fill a vector with realistic student ages 16..30
+    vector<int> ages_vector(n);
+    mt19937 gen(206);
+    uniform_int_distribution<int> dist(16, 30);
+    for (int& a : ages_vector)
+        a = dist(gen);
+
+    int age = 21;
+    ptrdiff_t expected = 0, actual = 0;
+
+    double t_std = median_seconds(n, reps, [&] { expected = count(ages_vector.cbegin(), ages_vector.cend(), age); });
+    double t_simd = median_seconds(n, reps, [&] { actual = count_equal(ages_vector, age); });
+
+    double gb = double(n) * sizeof(int) / 1e9;
+    cout << "elements           : " << n << '\n';
+    cout << "count_equal path   : " << count_equal_isa() << '\n';
+    cout << "std::count         : " << t_std * 1e3 << " ms, " << gb / t_std << " GB/s\n";
+    cout << "count_equal        : " << t_simd * 1e3 << " ms, " << gb / t_simd << " GB/s\n";
+    cout << "speed-up           : " << t_std / t_simd << "x\n";
+
+    if (expected != actual) {
+        cout << "MISMATCH: std::count = " << expected << ", count_equal = " << actual << endl;
+        return 1;
+    }
+    cout << "results match (" << actual << " students aged " << age << ")" << endl;
+    return 0;
+}
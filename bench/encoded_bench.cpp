@@ -0,0 +1,62 @@
+// encoded_bench - compares a vector<int> with run-length and dictionary encoded ages
+//
+// usage:  encoded_bench [number_of_elements] [repetitions]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "../encoded_ages.h"
+#include "bench_harness.h"
+using namespace std;
+
+void report(const char* name, double t_vector, double t_encoded)
+{
+    cout << name << t_vector * 1e3 << " ms -> " << t_encoded * 1e3 << " ms ("
+         << t_vector / t_encoded << "x)\n";
+}
+
+/**
+ * Time count(21) and count_if(x < 18) on "ages" and on the same ages in
+ * an encoded container.  Returns false if any answer differs.
+ */
+template <typename Encoded>
+bool compare(const char* title, const vector<int>& ages, int reps)
+{
+    Encoded encoded(ages);
+    ptrdiff_t count_v = 0, count_e = 0, below_v = 0, below_e = 0;
+    double tc_v = median_seconds(ages.size(), reps, [&] { count_v = count(ages.cbegin(), ages.cend(), 21); });
+    double tc_e = median_seconds(ages.size(), reps, [&] { count_e = encoded.count(21); });
+    double ti_v = median_seconds(ages.size(), reps, [&] { below_v = pred::count_if(ages.cbegin(), ages.cend(), pred::x < 18); });
+    double ti_e = median_seconds(ages.size(), reps, [&] { below_e = encoded.count_if(pred::x < 18); });
+    bool same = equal(encoded.begin(), encoded.end(), ages.begin(), ages.end());
+
+    double vector_mb = ages.size() * sizeof(int) / 1e6, encoded_mb = encoded.memory_bytes() / 1e6;
+    cout << title << '\n';
+    cout << "  memory           : " << vector_mb << " MB -> " << encoded_mb << " MB\n";
+    report("  count(21)        : ", tc_v, tc_e);
+    report("  count_if(x < 18) : ", ti_v, ti_e);
+    return same && count_v == count_e && below_v == below_e;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 50'000'000;
+    int reps = argc > 2 ? atoi(argv[2]) : 5;
+
+    // the ages populate_vector() adds, repeated - a handful of distinct ages
+    const int pattern[] = {18, 17, 21, 18, 21};
+    vector<int> ages_vector(n);
+    for (size_t i = 0; i < n; i++)
+        ages_vector[i] = pattern[i % 5];
+
+    bool ok = compare<DictionaryAges>("dictionary, ages as populated:", ages_vector, reps);
+    sort(ages_vector.begin(), ages_vector.end());
+    ok &= compare<RunLengthAges>("run-length, ages sorted:", ages_vector, reps);
+
+    if (!ok) {
+        cout << "MISMATCH: the encoded ages give different results" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+// load_bench - measures how fast ages are loaded from text and binary files
+//
+// usage:  load_bench [number_of_ages] [directory_for_temporary_files]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../age_loader.h"
+#include "../mapped_ages.h"
+using namespace std;
+
+void report(const string& name, const LoadStats& stats)
+{
+    cout << name << stats.values << " ages, " << stats.bytes / 1e6 << " MB in "
+         << stats.seconds * 1e3 << " ms = " << stats.mb_per_second() << " MB/s\n";
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10'000'000;
+    string dir = argc > 2 ? argv[2] : "/tmp";
+
+    vector<int> ages_vector(n);
+    mt19937 gen(206);
+    uniform_int_distribution<int> dist(16, 30);
+    for (int& a : ages_vector)
+        a = dist(gen);
+
+    string text_path = dir + "/sam206_ages.txt";
+    string binary_path = dir + "/sam206_ages.bin";
+    save_ages_text(text_path, ages_vector);
+    save_ages_binary(binary_path, ages_vector);
+
+    vector<int> loaded;
+    LoadStats text = load_ages_text(text_path, loaded);
+    bool text_ok = (loaded == ages_vector);
+    LoadStats parallel = load_ages_text_parallel(text_path, loaded);
+    bool parallel_ok = (loaded == ages_vector);
+    LoadStats binary = load_ages_binary(binary_path, loaded);
+    bool binary_ok = (loaded == ages_vector);
+    LoadStats text_async = load_ages_text_async(text_path, loaded);
+    bool text_async_ok = (loaded == ages_vector);
+    LoadStats binary_async = load_ages_binary_async(binary_path, loaded);
+    bool binary_async_ok = (loaded == ages_vector);
+
+    // mapping the file does not read it - the pages are read by the count
+    auto start = chrono::steady_clock::now();
+    bool mapped_ok;
+    double map_seconds;
+    {
+        MappedAges mapped(binary_path);
+        map_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        mapped_ok = equal(mapped.cbegin(), mapped.cend(), ages_vector.cbegin(), ages_vector.cend());
+    }
+
+    report("text   : ", text);
+    report("text x" + to_string(ThreadPool::shared().size()) + " threads : ", parallel);
+    report("binary : ", binary);
+    cout << "mmap   : opened in " << map_seconds * 1e3 << " ms (no copy)\n";
+    cout << "async reads use " << async_read_method() << ":\n";
+    report("text   : ", text_async);
+    report("binary : ", binary_async);
+    cout << "async speed-up: text " << text.seconds / text_async.seconds << "x, binary "
+         << binary.seconds / binary_async.seconds << "x\n";
+
+    remove(text_path.c_str());
+    remove(binary_path.c_str());
+
+    if (!text_ok || !parallel_ok || !binary_ok || !mapped_ok || !text_async_ok || !binary_async_ok) {
+        cout << "MISMATCH: loaded ages differ from the ages saved" << endl;
+        return 1;
+    }
+    return 0;
+}
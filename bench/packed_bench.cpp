@@ -0,0 +1,71 @@
+// packed_bench - compares scans of a vector<int> with scans of PackedAges
+//
+// usage:  packed_bench [number_of_elements] [repetitions]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../packed_ages.h"
+#include "bench_harness.h"
+using namespace std;
+
+void report(const char* name, double t_vector, double t_packed)
+{
+    cout << name << t_vector * 1e3 << " ms -> " << t_packed * 1e3 << " ms ("
+         << t_vector / t_packed << "x)\n";
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 50'000'000;
+    int reps = argc > 2 ? atoi(argv[2]) : 5;
+
+    vector<int> ages_vector(n);
+    mt19937 gen(206);
+    uniform_int_distribution<int> dist(0, 127);
+    for (int& a : ages_vector)
+        a = dist(gen);
+    PackedAges packed(ages_vector);
+
+    ptrdiff_t count_v = 0, count_p = 0, below_v = 0, below_p = 0;
+    bool all_v = false, all_p = false, none_v = false, none_p = false;
+    size_t found_v = 0, found_p = 0;
+
+    // every query below is an interval, so PackedAges answers it on the codes
+    double tc_v = median_seconds(n, reps, [&] { count_v = count(ages_vector.cbegin(), ages_vector.cend(), 21); });
+    double tc_p = median_seconds(n, reps, [&] { count_p = packed.count(21); });
+    double ti_v = median_seconds(n, reps, [&] { below_v = pred::count_if(ages_vector.cbegin(), ages_vector.cend(), pred::x < 18); });
+    double ti_p = median_seconds(n, reps, [&] { below_p = packed.count_if(pred::x < 18); });
+    double ta_v = median_seconds(n, reps, [&] { all_v = pred::all_of(ages_vector.cbegin(), ages_vector.cend(), pred::x >= 0); });
+    double ta_p = median_seconds(n, reps, [&] { all_p = packed.all_of(pred::x >= 0); });
+    double tn_v = median_seconds(n, reps, [&] { none_v = pred::none_of(ages_vector.cbegin(), ages_vector.cend(), pred::x > 127); });
+    double tn_p = median_seconds(n, reps, [&] { none_p = packed.none_of(pred::x > 127); });
+    // the age is in no segment's min..max, so find() skips every segment
+    double tf_v = median_seconds(n, reps, [&] { found_v = find(ages_vector.cbegin(), ages_vector.cend(), 200) - ages_vector.cbegin(); });
+    double tf_p = median_seconds(n, reps, [&] { found_p = packed.find(200).index(); });
+    // mod<2> == 0 is not an interval - the segments are unpacked first
+    ptrdiff_t even_v = 0, even_p = 0;
+    double te_v = median_seconds(n, reps, [&] { even_v = pred::count_if(ages_vector.cbegin(), ages_vector.cend(), pred::mod<2> == 0); });
+    double te_p = median_seconds(n, reps, [&] { even_p = packed.count_if(pred::mod<2> == 0); });
+
+    double vector_mb = n * sizeof(int) / 1e6, packed_mb = packed.memory_bytes() / 1e6;
+    cout << "elements           : " << n << " ages 0..127\n";
+    cout << "unpack path        : " << packed_ages_isa() << '\n';
+    cout << "memory             : " << vector_mb << " MB -> " << packed_mb << " MB ("
+         << vector_mb / packed_mb << "x smaller)\n";
+    report("count(21)          : ", tc_v, tc_p);
+    report("count_if(x < 18)   : ", ti_v, ti_p);
+    report("all_of(x >= 0)     : ", ta_v, ta_p);
+    report("none_of(x > 127)   : ", tn_v, tn_p);
+    report("find(200)          : ", tf_v, tf_p);
+    report("count_if(even)     : ", te_v, te_p);
+
+    if (count_v != count_p || below_v != below_p || all_v != all_p || none_v != none_p
+        || found_v != found_p || even_v != even_p) {
+        cout << "MISMATCH: the packed ages give different results" << endl;
+        return 1;
+    }
+    return 0;
+}
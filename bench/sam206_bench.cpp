@@ -0,0 +1,212 @@
+// sam206_bench - times every vector operation that main.cpp demonstrates,
+// for vectors of 10 up to max_elements ages, with several kinds of data
+//
+// usage:  sam206_bench [max_elements] [repetitions]
+//
+// Sizes are 10, 100, 1000 ... up to max_elements (default 10 million).
+// 10^9 works, but needs about 12 GB of memory: the vector, a copy for
+// the equality test, and fresh copies for the operations that change it.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "../compact.h"
+#include "../count_equal.h"
+#include "../output_buffer.h"
+#include "../predicate.h"
+#include "bench_harness.h"
+using namespace std;
+
+namespace {
+
+// The erase() loop moves every later element on each erase - O(n^2) - so
+// it is only timed up to this size
+constexpr size_t MAX_QUADRATIC = 10'000;
+
+// A stream buffer that throws the text away, so display() is timed without the terminal
+class NullBuffer : public streambuf {
+protected:
+    int_type overflow(int_type c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+struct Distribution {
+    const char* name;
+    vector<int> (*make)(size_t n);
+};
+
+vector<int> main_ages(size_t n)        // the five ages populate_vector() uses, repeated
+{
+    const int ages[] = {18, 17, 21, 18, 21};
+    vector<int> v(n);
+    for (size_t i = 0; i < n; i++)
+        v[i] = ages[i % 5];
+    return v;
+}
+
+vector<int> uniform_ages(size_t n)     // random student ages 16..30
+{
+    mt19937 gen(206);
+    uniform_int_distribution<int> dist(16, 30);
+    vector<int> v(n);
+    for (int& a : v)
+        a = dist(gen);
+    return v;
+}
+
+vector<int> sorted_ages(size_t n)      // 16..30 in increasing order
+{
+    vector<int> v = uniform_ages(n);
+    sort(v.begin(), v.end());
+    return v;
+}
+
+vector<int> constant_ages(size_t n)    // every student is 18 - no early exits for find(17)
+{
+    return vector<int>(n, 18);
+}
+
+vector<int> wide_values(size_t n)      // any int at all
+{
+    mt19937 gen(206);
+    vector<int> v(n);
+    for (int& a : v)
+        a = int(gen());
+    return v;
+}
+
+const Distribution distributions[] = {
+    {"main's ages", main_ages},
+    {"uniform 16..30", uniform_ages},
+    {"sorted 16..30", sorted_ages},
+    {"constant 18", constant_ages},
+    {"wide random", wide_values},
+};
+
+void report(const string& operation, const Timing& t)
+{
+    cout << "  " << left << setw(36) << operation << right
+         << setw(14) << t.median_ns << setw(14) << t.p99_ns << setw(12) << t.ns_per_element << '\n';
+}
+
+void run_all(const vector<int>& data, const BenchOptions& options)
+{
+    const size_t n = data.size();
+    const vector<int> same = data;      // equal copy for the == test
+    NullBuffer null_buffer;
+    ostream null_stream(&null_buffer);
+    OutputBuffer out(null_stream, FlushPolicy::EveryLine);
+    auto nothing = [] { return 0; };
+    auto copy = [&] { return data; };
+
+    report("refill (clear + push_back each age)", measure(n, options, copy, [&](vector<int>& v) {
+        v.clear();
+        for (int a : data)
+            v.push_back(a);
+        do_not_optimize(v.data());
+    }));
+    report("display (cout << each element)", measure(n, options, nothing, [&](int) {
+        for (size_t i = 0; i < n; i++) {
+            if (i != 0)
+                null_stream << ",";
+            null_stream << data[i];
+        }
+        null_stream << endl;
+    }));
+    report("display (OutputBuffer)", measure(n, options, nothing, [&](int) {
+        out.write_list(data);
+    }));
+    report("count", measure(n, options, nothing, [&](int) {
+        do_not_optimize(count(data.cbegin(), data.cend(), 21));
+    }));
+    report("count_equal", measure(n, options, nothing, [&](int) {
+        do_not_optimize(count_equal(data, 21));
+    }));
+    report("count_if (lambda i < 18)", measure(n, options, nothing, [&](int) {
+        do_not_optimize(count_if(data.begin(), data.end(), [](int i) { return i < 18; }));
+    }));
+    report("pred::count_if (x < 18)", measure(n, options, nothing, [&](int) {
+        do_not_optimize(pred::count_if(data.begin(), data.end(), pred::x < 18));
+    }));
+    report("pop_back", measure(n, options, copy, [](vector<int>& v) {
+        v.pop_back();
+        do_not_optimize(v.size());
+    }));
+    if (n > 2) {
+        report("erase(begin() + 2)", measure(n, options, copy, [](vector<int>& v) {
+            v.erase(v.begin() + 2);
+            do_not_optimize(v.data());
+        }));
+    }
+    if (n <= MAX_QUADRATIC) {
+        report("erase even (erase() loop)", measure(n, options, copy, [](vector<int>& v) {
+            for (auto iter = v.begin(); iter != v.end(); ) {
+                if (*iter % 2 == 0)
+                    iter = v.erase(iter);
+                else
+                    ++iter;
+            }
+            do_not_optimize(v.data());
+        }));
+    } else {
+        cout << "  " << left << setw(36) << "erase even (erase() loop)" << right
+             << "   skipped - O(n^2) above " << MAX_QUADRATIC << " elements\n";
+    }
+    report("erase even (erase_matching)", measure(n, options, copy, [](vector<int>& v) {
+        erase_matching(v, [](int i) { return i % 2 == 0; });
+        do_not_optimize(v.data());
+    }));
+    report("all_of (lambda i > 16)", measure(n, options, nothing, [&](int) {
+        do_not_optimize(all_of(data.cbegin(), data.cend(), [](int i) { return i > 16; }));
+    }));
+    report("pred::all_of (x > 16)", measure(n, options, nothing, [&](int) {
+        do_not_optimize(pred::all_of(data.cbegin(), data.cend(), pred::x > 16));
+    }));
+    report("none_of (lambda i < 17)", measure(n, options, nothing, [&](int) {
+        do_not_optimize(none_of(data.cbegin(), data.cend(), [](int i) { return i < 17; }));
+    }));
+    report("pred::none_of (x < 17)", measure(n, options, nothing, [&](int) {
+        do_not_optimize(pred::none_of(data.cbegin(), data.cend(), pred::x < 17));
+    }));
+    report("find 17", measure(n, options, nothing, [&](int) {
+        do_not_optimize(find(begin(data), end(data), 17));
+    }));
+    report("find_if (lambda is_even)", measure(n, options, nothing, [&](int) {
+        do_not_optimize(find_if(begin(data), end(data), [](int i) { return i % 2 == 0; }));
+    }));
+    report("pred::find_if (mod<2> == 0)", measure(n, options, nothing, [&](int) {
+        do_not_optimize(pred::find_if(begin(data), end(data), pred::mod<2> == 0));
+    }));
+    report("vector == vector", measure(n, options, nothing, [&](int) {
+        do_not_optimize(data == same);
+    }));
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t max_elements = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10'000'000;
+    BenchOptions options;
+    if (argc > 2)
+        options.repetitions = max(1, atoi(argv[2]));
+
+    cout << "count_equal path: " << count_equal_isa() << ", "
+         << options.repetitions << " repetitions after " << options.warmup << " warmup runs\n";
+    cout << fixed << setprecision(2);
+
+    for (const Distribution& dist : distributions) {
+        for (size_t n = 10; n <= max_elements; n *= 10) {
+            vector<int> data = dist.make(n);
+            cout << '\n' << dist.name << ", " << n << " elements\n";
+            cout << "  " << left << setw(36) << "operation" << right
+                 << setw(14) << "median ns" << setw(14) << "p99 ns" << setw(12) << "ns/element" << '\n';
+            run_all(data, options);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+// scaling_bench - how count_if() speeds up from 1 to N threads, comparing
+// the static split of parallel.h with the work-stealing scheduler
+//
+// usage:  scaling_bench [number_of_elements] [max_threads]
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../parallel.h"
+#include "../work_stealing.h"
+#include "bench_harness.h"
+using namespace std;
+
+/**
+ * A predicate whose cost depends on the element: ages over 60 (which are
+ * all in the first eighth of the vector) take far longer to test.  With a
+ * static split, the thread that gets the first chunk does most of the work.
+ */
+bool uneven_predicate(int age)
+{
+    if (age <= 60)
+        return age < 18;
+    unsigned h = unsigned(age);
+    for (int i = 0; i < 200; i++)
+        h = h * 2654435761u + 1;
+    return (h & 1) != 0;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4'000'000;
+    unsigned max_threads = argc > 2 ? unsigned(atoi(argv[2])) : max(1u, thread::hardware_concurrency());
+
+    vector<int> ages_vector(n);
+    mt19937 gen(206);
+    uniform_int_distribution<int> young(16, 30), old(61, 99);
+    for (size_t i = 0; i < n; i++)
+        ages_vector[i] = (i < n / 8) ? old(gen) : young(gen);
+    const int* first = ages_vector.data();
+    const int* last = first + n;
+
+    ptrdiff_t expected = count_if(first, last, uneven_predicate);
+    double base_pool = 0, base_steal = 0;
+
+    cout << "threads  static split (ms)  speed-up  work stealing (ms)  speed-up\n";
+    cout << fixed << setprecision(2);
+    for (unsigned threads = 1; threads <= max_threads; threads++) {
+        ThreadPool pool(threads);
+        WorkStealingScheduler scheduler(threads);
+        ptrdiff_t a = 0, b = 0;
+        double t_pool = median_seconds(n, 3, [&] { a = par::count_if(first, last, uneven_predicate, pool); });
+        double t_steal = median_seconds(n, 3, [&] { b = steal::count_if(first, last, uneven_predicate, scheduler); });
+        if (a != expected || b != expected) {
+            cout << "MISMATCH with " << threads << " threads" << endl;
+            return 1;
+        }
+        if (threads == 1) {
+            base_pool = t_pool;
+            base_steal = t_steal;
+        }
+        cout << setw(7) << threads << setw(19) << t_pool * 1e3 << setw(10) << base_pool / t_pool
+             << setw(20) << t_steal * 1e3 << setw(10) << base_steal / t_steal << '\n';
+    }
+    return 0;
+}
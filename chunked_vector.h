@@ -0,0 +1,349 @@
+// chunked_vector - a sequence stored in blocks, for cheap erase in the middle
+//
+// https://en.wikipedia.org/wiki/Unrolled_linked_list
+
+#ifndef SAM206_CHUNKED_VECTOR_H
+#define SAM206_CHUNKED_VECTOR_H
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ *  ChunkedVector
+ *  vector::erase(begin() + 2) has to move every element after the third
+ *  one down by one place - O(n) moves.  ChunkedVector keeps its elements
+ *  in a list of blocks of about sqrt(n) elements each.  Erasing or
+ *  inserting only moves elements inside one block, and then updates the
+ *  table of where each of the sqrt(n) blocks starts:  O(sqrt(n)) instead
+ *  of O(n).  For 10^9 elements that is tens of thousands of moves, not
+ *  a billion.
+ *
+ *  Inside a block the elements are next to each other in memory.  The
+ *  iterators check for the end of a block on every ++, which makes an
+ *  <algorithm> scan 2-3 times slower than on a vector; for_each_block()
+ *  hands over each block as a plain array and scans at vector speed.
+ *
+ *  It has the same interface as vector for everything main.cpp does:
+ *      push_back, pop_back, clear, empty, size, operator[], at,
+ *      begin/end/cbegin/cend (random access iterators), erase, insert,
+ *      == != < <= > >=
+ *  so it can be used in place of vector<int> ages_vector, and the
+ *  <algorithm> functions work on its iterators.
+ *
+ *  Blocks are split in two when they reach twice the block size, and
+ *  merged with a neighbour when they shrink below a quarter of it.  The
+ *  block size starts at BLOCK and follows sqrt(n): when n has grown or
+ *  shrunk about 4-fold, the block size doubles or halves and the elements
+ *  are regrouped - O(n), but only after O(n) changes, so O(1) per change
+ *  on average.  As with vector, push_back(), erase() and insert() may
+ *  invalidate iterators - use the iterator erase() and insert() return.
+ */
+template <typename T, std::size_t BLOCK = 1024>
+class ChunkedVector {
+    static_assert(BLOCK >= 4, "blocks must hold at least 4 elements");
+
+    template <bool Const>
+    class Iterator {
+        using Owner = std::conditional_t<Const, const ChunkedVector, ChunkedVector>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<Const, const T&, T&>;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+
+        Iterator() = default;
+        Iterator(Owner* owner, std::size_t block, std::size_t offset)
+            : owner(owner), block(block), offset(offset) {}
+        // an iterator converts to a const_iterator, as with vector
+        template <bool C = Const, typename = std::enable_if_t<C>>
+        Iterator(const Iterator<false>& it) : owner(it.owner), block(it.block), offset(it.offset) {}
+
+        reference operator*() const { return owner->blocks[block][offset]; }
+        pointer operator->() const { return &**this; }
+        reference operator[](difference_type n) const { return *(*this + n); }
+
+        Iterator& operator++()
+        {
+            if (++offset == owner->blocks[block].size()) {
+                ++block;
+                offset = 0;
+            }
+            return *this;
+        }
+        Iterator operator++(int) { Iterator old = *this; ++*this; return old; }
+        Iterator& operator--()
+        {
+            if (offset == 0)
+                offset = owner->blocks[--block].size();
+            --offset;
+            return *this;
+        }
+        Iterator operator--(int) { Iterator old = *this; --*this; return old; }
+
+        Iterator& operator+=(difference_type n) { return *this = owner->template at_index<Const>(index() + n); }
+        Iterator& operator-=(difference_type n) { return *this += -n; }
+        friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+        friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+        friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const Iterator& a, const Iterator& b) { return a.index() - b.index(); }
+
+        bool operator==(const Iterator& other) const { return block == other.block && offset == other.offset; }
+        std::strong_ordering operator<=>(const Iterator& other) const
+        {
+            if (block != other.block)
+                return block <=> other.block;
+            return offset <=> other.offset;
+        }
+
+        // position of the element from the start of the container
+        difference_type index() const { return difference_type(owner->start_of(block) + offset); }
+
+    private:
+        friend class ChunkedVector;
+        template <bool> friend class Iterator;
+
+        Owner* owner = nullptr;
+        std::size_t block = 0;
+        std::size_t offset = 0;
+    };
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    ChunkedVector() = default;
+    ChunkedVector(std::initializer_list<T> values)
+    {
+        for (const T& v : values)
+            push_back(v);
+    }
+
+    size_type size() const { return count; }
+    bool empty() const { return count == 0; }
+    // the size blocks are split and merged around - BLOCK, or about sqrt(size())
+    size_type block_size() const { return target; }
+
+    void clear()
+    {
+        blocks.clear();
+        starts.clear();
+        count = 0;
+        target = BLOCK;
+    }
+
+    void push_back(const T& value)
+    {
+        if (blocks.empty() || blocks.back().size() >= target) {
+            blocks.emplace_back();
+            blocks.back().reserve(target);
+            starts.push_back(count);
+        }
+        blocks.back().push_back(value);
+        ++count;
+        resize_blocks();
+    }
+
+    void pop_back()
+    {
+        blocks.back().pop_back();
+        --count;
+        if (blocks.back().empty()) {
+            blocks.pop_back();
+            starts.pop_back();
+        }
+        resize_blocks();
+    }
+
+    T& operator[](size_type i) { auto [b, o] = locate(i); return blocks[b][o]; }
+    const T& operator[](size_type i) const { auto [b, o] = locate(i); return blocks[b][o]; }
+    T& at(size_type i) { check(i); return (*this)[i]; }
+    const T& at(size_type i) const { check(i); return (*this)[i]; }
+    T& front() { return blocks.front().front(); }
+    T& back() { return blocks.back().back(); }
+    const T& front() const { return blocks.front().front(); }
+    const T& back() const { return blocks.back().back(); }
+
+    iterator begin() { return iterator(this, 0, 0); }
+    iterator end() { return iterator(this, blocks.size(), 0); }
+    const_iterator begin() const { return const_iterator(this, 0, 0); }
+    const_iterator end() const { return const_iterator(this, blocks.size(), 0); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    iterator erase(const_iterator pos)
+    {
+        size_type index = size_type(pos.index());
+        std::vector<T>& block = blocks[pos.block];
+        block.erase(block.begin() + difference_type(pos.offset));
+        --count;
+        rebalance(pos.block);
+        resize_blocks();
+        return at_index<false>(difference_type(index));
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_type index = size_type(first.index());
+        for (difference_type n = last - first; n > 0; ) {
+            // remove as much of the range as lies in one block at a time
+            auto [b, o] = locate(index);
+            std::vector<T>& block = blocks[b];
+            size_type take = std::min(size_type(n), block.size() - o);
+            block.erase(block.begin() + difference_type(o), block.begin() + difference_type(o + take));
+            count -= take;
+            n -= difference_type(take);
+            rebalance(b);
+        }
+        resize_blocks();
+        return at_index<false>(difference_type(index));
+    }
+
+    iterator insert(const_iterator pos, const T& value)
+    {
+        size_type index = size_type(pos.index());
+        if (index == count) {
+            push_back(value);
+        } else {
+            std::vector<T>& block = blocks[pos.block];
+            block.insert(block.begin() + difference_type(pos.offset), value);
+            ++count;
+            rebalance(pos.block);
+            resize_blocks();
+        }
+        return at_index<false>(difference_type(index));
+    }
+
+    /**
+     * Calls f(pointer, length) for each block in order - the fastest way to
+     * scan every element, since each block is an ordinary array.
+     */
+    template <typename F>
+    void for_each_block(F f) const
+    {
+        for (const std::vector<T>& block : blocks)
+            f(block.data(), block.size());
+    }
+
+    friend bool operator==(const ChunkedVector& a, const ChunkedVector& b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+    }
+    friend auto operator<=>(const ChunkedVector& a, const ChunkedVector& b)
+    {
+        return std::lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+private:
+    void check(size_type i) const
+    {
+        if (i >= count)
+            throw std::out_of_range("ChunkedVector::at: index " + std::to_string(i)
+                                    + " >= size " + std::to_string(count));
+    }
+
+    size_type start_of(size_type block) const { return block < starts.size() ? starts[block] : count; }
+
+    // which block holds element i, and where in that block
+    std::pair<size_type, size_type> locate(size_type i) const
+    {
+        size_type b = size_type(std::upper_bound(starts.begin(), starts.end(), i) - starts.begin()) - 1;
+        return {b, i - starts[b]};
+    }
+
+    template <bool Const>
+    Iterator<Const> at_index(difference_type i) const
+    {
+        using Owner = std::conditional_t<Const, const ChunkedVector, ChunkedVector>;
+        Owner* self = const_cast<Owner*>(this);
+        if (size_type(i) >= count)
+            return Iterator<Const>(self, blocks.size(), 0);
+        auto [b, o] = locate(size_type(i));
+        return Iterator<Const>(self, b, o);
+    }
+
+    // After block b changed size: split it, merge it, or drop it if empty,
+    // then recompute where the blocks start.
+    void rebalance(size_type b)
+    {
+        std::vector<T>& block = blocks[b];
+        if (block.size() >= 2 * target) {
+            std::vector<T> upper(block.begin() + difference_type(target), block.end());
+            upper.reserve(target);
+            block.resize(target);
+            blocks.insert(blocks.begin() + difference_type(b + 1), std::move(upper));
+        } else if (block.empty()) {
+            blocks.erase(blocks.begin() + difference_type(b));
+        } else if (block.size() < target / 4 && blocks.size() > 1) {
+            // merge with the smaller neighbour, unless that makes it too big
+            size_type left = b > 0 ? b - 1 : b;
+            size_type right = left + 1;
+            if (b > 0 && b + 1 < blocks.size() && blocks[b + 1].size() < blocks[b - 1].size()) {
+                left = b;
+                right = b + 1;
+            }
+            if (blocks[left].size() + blocks[right].size() < 2 * target) {
+                blocks[left].insert(blocks[left].end(), blocks[right].begin(), blocks[right].end());
+                blocks.erase(blocks.begin() + difference_type(right));
+            }
+        }
+        starts.resize(blocks.size());
+        size_type s = b > 0 ? starts[b - 1] + blocks[b - 1].size() : 0;
+        for (size_type i = (b > 0 ? b : 0); i < blocks.size(); i++) {
+            starts[i] = s;
+            s += blocks[i].size();
+        }
+    }
+
+    // Once n reaches 4 * target^2 (sqrt(n) = 2 * target) the block size
+    // doubles; once it falls below target^2 / 4 it halves, down to BLOCK.
+    // Then the elements are regrouped into full blocks of the new size.
+    void resize_blocks()
+    {
+        size_type t = target;
+        while (count >= 4 * t * t)
+            t *= 2;
+        while (t > BLOCK && 4 * count < t * t)
+            t /= 2;
+        if (t == target)
+            return;
+        target = t;
+
+        std::vector<std::vector<T>> regrouped;
+        regrouped.reserve(count / t + 1);
+        for (std::vector<T>& block : blocks) {
+            for (T& value : block) {
+                if (regrouped.empty() || regrouped.back().size() == t) {
+                    regrouped.emplace_back();
+                    regrouped.back().reserve(t);
+                }
+                regrouped.back().push_back(std::move(value));
+            }
+        }
+        blocks = std::move(regrouped);
+        starts.resize(blocks.size());
+        for (size_type b = 0, s = 0; b < blocks.size(); s += blocks[b].size(), b++)
+            starts[b] = s;
+    }
+
+    std::vector<std::vector<T>> blocks;     // never contains an empty block
+    std::vector<size_type> starts;          // starts[b] = index of the first element of block b
+    size_type count = 0;
+    size_type target = BLOCK;               // block size, about sqrt(count)
+};
+
+#endif //SAM206_CHUNKED_VECTOR_H
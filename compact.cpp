@@ -0,0 +1,121 @@
+// compact - runtime dispatched SIMD stream compaction
+
+#include "compact.h"
+
+#include <array>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAM206_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+int* compact_scalar(int* dst, const int* src, ptrdiff_t n, const uint8_t* keep)
+{
+    for (ptrdiff_t i = 0; i < n; i++) {
+        *dst = src[i];          // always write, then advance only if kept
+        dst += keep[i] != 0;    // - no branch to mispredict
+    }
+    return dst;
+}
+
+#ifdef SAM206_X86
+
+// Turn 16 keep flags (one byte each) into a 16-bit mask, bit i = keep[i] != 0
+__attribute__((target("sse2")))
+unsigned keep_mask16(const uint8_t* keep)
+{
+    __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keep));
+    __m128i zero = _mm_cmpeq_epi8(flags, _mm_setzero_si128());
+    return ~unsigned(_mm_movemask_epi8(zero)) & 0xFFFF;
+}
+
+// For every 8-bit keep mask, the lane indices of the kept elements, packed
+// to the front.  e.g. mask 0b00000101 -> {0, 2, 0, 0, 0, 0, 0, 0}
+struct PermuteTable {
+    alignas(32) array<array<int, 8>, 256> lanes{};
+    PermuteTable()
+    {
+        for (int mask = 0; mask < 256; mask++) {
+            int k = 0;
+            for (int lane = 0; lane < 8; lane++)
+                if (mask & (1 << lane))
+                    lanes[mask][k++] = lane;
+        }
+    }
+};
+
+__attribute__((target("avx2")))
+int* compact_avx2(int* dst, const int* src, ptrdiff_t n, const uint8_t* keep)
+{
+    static const PermuteTable table;
+    ptrdiff_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        unsigned mask = keep_mask16(keep + i);
+        for (int half = 0; half < 2; half++) {
+            unsigned m = (mask >> (8 * half)) & 0xFF;
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 8 * half));
+            __m256i idx = _mm256_load_si256(reinterpret_cast<const __m256i*>(table.lanes[m].data()));
+            // all 8 lanes are stored, but dst only advances by the number kept.
+            // dst <= src, so the store never reaches past the 8 ints just loaded.
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_permutevar8x32_epi32(v, idx));
+            dst += __builtin_popcount(m);
+        }
+    }
+    return compact_scalar(dst, src + i, n - i, keep + i);
+}
+
+__attribute__((target("avx512f")))
+int* compact_avx512(int* dst, const int* src, ptrdiff_t n, const uint8_t* keep)
+{
+    ptrdiff_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __mmask16 mask = __mmask16(keep_mask16(keep + i));
+        __m512i v = _mm512_loadu_si512(src + i);
+        _mm512_mask_compressstoreu_epi32(dst, mask, v);
+        dst += __builtin_popcount(mask);
+    }
+    return compact_scalar(dst, src + i, n - i, keep + i);
+}
+
+#endif // SAM206_X86
+
+using compact_fn = int* (*)(int*, const int*, ptrdiff_t, const uint8_t*);
+
+struct Kernel {
+    compact_fn fn;
+    const char* name;
+};
+
+Kernel select_kernel()
+{
+#ifdef SAM206_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return {compact_avx512, "avx512"};
+    if (__builtin_cpu_supports("avx2"))
+        return {compact_avx2, "avx2"};
+#endif
+    return {compact_scalar, "scalar"};
+}
+
+const Kernel& kernel()
+{
+    static const Kernel chosen = select_kernel();
+    return chosen;
+}
+
+} // namespace
+
+int* compact_block(int* dst, const int* src, ptrdiff_t n, const uint8_t* keep)
+{
+    return kernel().fn(dst, src, n, keep);
+}
+
+const char* compact_isa()
+{
+    return kernel().name;
+}
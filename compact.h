@@ -0,0 +1,77 @@
+// compact - remove all matching elements from a vector in one pass
+//
+// https://en.cppreference.com/w/cpp/algorithm/remove
+
+#ifndef SAM206_COMPACT_H
+#define SAM206_COMPACT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ *  Compaction
+ *  Calling erase() once for each unwanted element moves all of the later
+ *  elements down every time - for a vector of n elements that is O(n^2)
+ *  moves.  erase_matching() instead slides every element that is kept
+ *  straight to its final position, so each element moves at most once.
+ *  The order of the remaining elements is unchanged.
+ *
+ *      erase_matching(ages_vector, pred::mod<2> == 0);    // remove even ages
+ *
+ *  It works on blocks of elements: first the predicate is evaluated for the
+ *  whole block (a loop without branches that the compiler vectorises), then
+ *  compact_block() packs the kept elements together using AVX-512 compress
+ *  or an AVX2 permute table, whichever the CPU supports.
+ */
+
+/**
+ * Copy the elements src[i] with keep[i] != 0 to dst, in order.
+ * dst may equal src, or be anywhere before it (in-place compaction).
+ * @return pointer just past the last element written
+ */
+int* compact_block(int* dst, const int* src, std::ptrdiff_t n, const std::uint8_t* keep);
+
+// Name of the code path chosen at runtime: "avx512", "avx2" or "scalar"
+const char* compact_isa();
+
+/**
+ * Remove every element of [first, last) for which pred(element) is true,
+ * sliding the kept elements to the front of the range.
+ * @return the new end of the range - the elements after it are unspecified
+ */
+template <typename Pred>
+int* compact_range(int* first, int* last, Pred pred)
+{
+    constexpr std::ptrdiff_t BLOCK = 1024;
+    std::uint8_t keep[BLOCK];
+
+    int* dst = first;
+    for (const int* src = first; src != last; ) {
+        std::ptrdiff_t size = std::min(BLOCK, last - src);
+        for (std::ptrdiff_t i = 0; i < size; i++)
+            keep[i] = !pred(src[i]);
+        dst = compact_block(dst, src, size, keep);
+        src += size;
+    }
+    return dst;
+}
+
+/**
+ * Remove every element for which pred(element) is true.
+ * pred can be a lambda or an expression from predicate.h.
+ * @return how many elements were removed
+ */
+template <typename Pred>
+std::size_t erase_matching(std::vector<int>& vect, Pred pred)
+{
+    int* first = vect.data();
+    int* end = compact_range(first, first + vect.size(), pred);
+
+    std::size_t removed = vect.size() - std::size_t(end - first);
+    vect.resize(std::size_t(end - first));
+    return removed;
+}
+
+#endif //SAM206_COMPACT_H
@@ -0,0 +1,133 @@
+// count_equal - runtime dispatched SIMD kernels for counting matches
+
+#include "count_equal.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAM206_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+ptrdiff_t count_equal_scalar(const int* first, const int* last, int value)
+{
+    ptrdiff_t n = 0;
+    for (; first != last; ++first)
+        n += (*first == value);     // no branch - add 0 or 1
+    return n;
+}
+
+#ifdef SAM206_X86
+
+// Each SIMD lane keeps its own 32-bit counter.  A compare gives -1 in a lane
+// that matched, so subtracting the compare result adds one.  The lane
+// counters are added into a 64-bit total every BLOCK iterations so they
+// can never overflow, whatever the size of the vector.
+constexpr ptrdiff_t BLOCK = 1 << 20;
+
+__attribute__((target("sse2")))
+ptrdiff_t count_equal_sse2(const int* first, const int* last, int value)
+{
+    ptrdiff_t n = 0;
+    const __m128i needle = _mm_set1_epi32(value);
+    while (last - first >= 4) {
+        ptrdiff_t steps = (last - first) / 4;
+        if (steps > BLOCK) steps = BLOCK;
+        __m128i acc = _mm_setzero_si128();
+        for (ptrdiff_t s = 0; s < steps; ++s, first += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+            acc = _mm_sub_epi32(acc, _mm_cmpeq_epi32(v, needle));
+        }
+        alignas(16) unsigned lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        n += ptrdiff_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+    return n + count_equal_scalar(first, last, value);
+}
+
+__attribute__((target("avx2")))
+ptrdiff_t count_equal_avx2(const int* first, const int* last, int value)
+{
+    ptrdiff_t n = 0;
+    const __m256i needle = _mm256_set1_epi32(value);
+    while (last - first >= 16) {
+        ptrdiff_t steps = (last - first) / 16;
+        if (steps > BLOCK) steps = BLOCK;
+        // two accumulators so that consecutive loads are independent
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        for (ptrdiff_t s = 0; s < steps; ++s, first += 16) {
+            __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+            __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + 8));
+            acc0 = _mm256_sub_epi32(acc0, _mm256_cmpeq_epi32(v0, needle));
+            acc1 = _mm256_sub_epi32(acc1, _mm256_cmpeq_epi32(v1, needle));
+        }
+        alignas(32) unsigned lanes[16];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc0);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes + 8), acc1);
+        for (unsigned lane : lanes)
+            n += lane;
+    }
+    return n + count_equal_sse2(first, last, value);
+}
+
+__attribute__((target("avx512f")))
+ptrdiff_t count_equal_avx512(const int* first, const int* last, int value)
+{
+    ptrdiff_t n = 0;
+    const __m512i needle = _mm512_set1_epi32(value);
+    for (; last - first >= 16; first += 16) {
+        __m512i v = _mm512_loadu_si512(first);
+        n += __builtin_popcount(_mm512_cmpeq_epi32_mask(v, needle));
+    }
+    // the tail is handled with a masked load - no scalar loop needed
+    if (first != last) {
+        __mmask16 tail = __mmask16((1u << (last - first)) - 1);
+        __m512i v = _mm512_maskz_loadu_epi32(tail, first);
+        n += __builtin_popcount(_mm512_mask_cmpeq_epi32_mask(tail, v, needle));
+    }
+    return n;
+}
+
+#endif // SAM206_X86
+
+using count_fn = ptrdiff_t (*)(const int*, const int*, int);
+
+struct Kernel {
+    count_fn fn;
+    const char* name;
+};
+
+Kernel select_kernel()
+{
+#ifdef SAM206_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return {count_equal_avx512, "avx512"};
+    if (__builtin_cpu_supports("avx2"))
+        return {count_equal_avx2, "avx2"};
+    if (__builtin_cpu_supports("sse2"))
+        return {count_equal_sse2, "sse2"};
+#endif
+    return {count_equal_scalar, "scalar"};
+}
+
+const Kernel& kernel()
+{
+    static const Kernel chosen = select_kernel();  // resolved once, thread-safe
+    return chosen;
+}
+
+} // namespace
+
+ptrdiff_t count_equal(const int* first, const int* last, int value)
+{
+    return kernel().fn(first, last, value);
+}
+
+const char* count_equal_isa()
+{
+    return kernel().name;
+}
@@ -0,0 +1,29 @@
+// count_equal - a SIMD replacement for count() over a vector of int
+//
+// https://en.cppreference.com/w/cpp/algorithm/count
+
+#ifndef SAM206_COUNT_EQUAL_H
+#define SAM206_COUNT_EQUAL_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ *  count_equal() returns the same result as
+ *      count(vect.cbegin(), vect.cend(), value)
+ *  but compares 4, 8 or 16 ints at a time using the widest SIMD
+ *  instructions that the CPU supports (SSE2, AVX2 or AVX-512).
+ *  The instruction set is picked once, at runtime, the first time the
+ *  function is called.  On other CPUs a plain scalar loop is used.
+ */
+std::ptrdiff_t count_equal(const int* first, const int* last, int value);
+
+inline std::ptrdiff_t count_equal(const std::vector<int>& vect, int value)
+{
+    return count_equal(vect.data(), vect.data() + vect.size(), value);
+}
+
+// Name of the code path chosen at runtime: "avx512", "avx2", "sse2" or "scalar"
+const char* count_equal_isa();
+
+#endif //SAM206_COUNT_EQUAL_H
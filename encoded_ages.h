@@ -0,0 +1,377 @@
+// encoded_ages - run-length and dictionary encoded containers of ages
+//
+// https://en.wikipedia.org/wiki/Run-length_encoding
+
+#ifndef SAM206_ENCODED_AGES_H
+#define SAM206_ENCODED_AGES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "predicate.h"
+
+/**
+ *  RunLengthAges
+ *  Stores each "run" of equal ages that are next to each other once, as
+ *  the age and where the run ends:
+ *
+ *      18 18 18 17 17 21 21 21 21   ->   18 until 3, 17 until 5, 21 until 9
+ *
+ *  count, count_if, find, find_if, all_of and none_of test each run once,
+ *  so they take time proportional to the number of runs, not of ages.
+ *  Iterating still gives every age, in the original order.
+ *
+ *  This only pays when equal ages are next to each other - after sorting,
+ *  or when the data arrives grouped.  In 18 17 21 18 21 ... every run has
+ *  length 1 and RunLengthAges is larger than a vector<int>; use
+ *  DictionaryAges for that.
+ *
+ *  Ages can be added and removed at the end only: push_back, pop_back and
+ *  clear.  operator[] finds the run with a binary search, O(log runs).
+ */
+class RunLengthAges {
+public:
+    // Random access iterator - remembers the run it is in, so ++ and * are O(1)
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = int;
+
+        const_iterator() = default;
+        const_iterator(const RunLengthAges* ages, std::size_t i) : ages(ages), i(i), run(ages->run_of(i)) {}
+
+        int operator*() const { return ages->values[run]; }
+        int operator[](difference_type n) const { return (*ages)[i + n]; }
+
+        const_iterator& operator++()
+        {
+            if (++i == ages->ends[run])
+                ++run;
+            return *this;
+        }
+        const_iterator operator++(int) { const_iterator old = *this; ++*this; return old; }
+        const_iterator& operator--()
+        {
+            --i;
+            if (run > 0 && i < ages->ends[run - 1])
+                --run;
+            return *this;
+        }
+        const_iterator operator--(int) { const_iterator old = *this; --*this; return old; }
+        const_iterator& operator+=(difference_type n)
+        {
+            i += n;
+            run = ages->run_of(i);
+            return *this;
+        }
+        const_iterator& operator-=(difference_type n) { return *this += -n; }
+
+        friend const_iterator operator+(const_iterator it, difference_type n) { return it += n; }
+        friend const_iterator operator+(difference_type n, const_iterator it) { return it += n; }
+        friend const_iterator operator-(const_iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const_iterator a, const_iterator b)
+        {
+            return difference_type(a.i) - difference_type(b.i);
+        }
+
+        bool operator==(const const_iterator& other) const { return i == other.i; }
+        auto operator<=>(const const_iterator& other) const { return i <=> other.i; }
+
+        std::size_t index() const { return i; }
+
+    private:
+        const RunLengthAges* ages = nullptr;
+        std::size_t i = 0;
+        std::size_t run = 0;
+    };
+    using iterator = const_iterator;
+    using value_type = int;
+    using size_type = std::size_t;
+
+    RunLengthAges() = default;
+    RunLengthAges(std::initializer_list<int> ages)
+    {
+        for (int age : ages)
+            push_back(age);
+    }
+    explicit RunLengthAges(const std::vector<int>& ages)
+    {
+        for (int age : ages)
+            push_back(age);
+    }
+
+    void push_back(int age)
+    {
+        if (!values.empty() && values.back() == age) {
+            ++ends.back();
+        } else {
+            values.push_back(age);
+            ends.push_back(size() + 1);
+        }
+    }
+    void pop_back()
+    {
+        if (--ends.back() == (ends.size() > 1 ? ends[ends.size() - 2] : 0)) {
+            values.pop_back();
+            ends.pop_back();
+        }
+    }
+    void clear()
+    {
+        values.clear();
+        ends.clear();
+    }
+
+    size_type size() const { return ends.empty() ? 0 : ends.back(); }
+    bool empty() const { return ends.empty(); }
+    int operator[](size_type i) const { return values[run_of(i)]; }
+    int at(size_type i) const
+    {
+        if (i >= size())
+            throw std::out_of_range("RunLengthAges::at: index " + std::to_string(i)
+                                    + " >= size " + std::to_string(size()));
+        return (*this)[i];
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // The number of runs, and the age and length of run k
+    size_type runs() const { return values.size(); }
+    int run_age(size_type k) const { return values[k]; }
+    size_type run_length(size_type k) const { return ends[k] - run_start(k); }
+
+    size_type memory_bytes() const { return values.size() * sizeof(int) + ends.size() * sizeof(size_type); }
+
+    std::ptrdiff_t count(int age) const { return count_if(pred::x == age); }
+
+    // Same as count_if(cbegin(), cend(), e) for a predicate from predicate.h
+    template <typename P>
+    std::ptrdiff_t count_if(const pred::Expr<P>& e) const
+    {
+        const P& p = e.self();
+        std::ptrdiff_t n = 0;
+        for (size_type k = 0; k < values.size(); k++)
+            n += p(values[k]) ? std::ptrdiff_t(run_length(k)) : 0;
+        return n;
+    }
+
+    const_iterator find(int age) const { return find_if(pred::x == age); }
+
+    template <typename P>
+    const_iterator find_if(const pred::Expr<P>& e) const
+    {
+        const P& p = e.self();
+        for (size_type k = 0; k < values.size(); k++)
+            if (p(values[k]))
+                return const_iterator(this, run_start(k));
+        return end();
+    }
+
+    template <typename P>
+    bool none_of(const pred::Expr<P>& e) const { return find_if(e) == end(); }
+    template <typename P>
+    bool all_of(const pred::Expr<P>& e) const { return none_of(!e); }
+
+    // equal ages are always merged into one run, so equal sequences have equal runs
+    bool operator==(const RunLengthAges& other) const = default;
+
+private:
+    size_type run_start(size_type k) const { return k == 0 ? 0 : ends[k - 1]; }
+    // the run holding age i (runs() for i == size())
+    size_type run_of(size_type i) const
+    {
+        return size_type(std::upper_bound(ends.begin(), ends.end(), i) - ends.begin());
+    }
+
+    std::vector<int> values;        // the age of each run
+    std::vector<size_type> ends;    // run k holds ages ends[k-1] .. ends[k]-1
+};
+
+/**
+ *  DictionaryAges
+ *  Keeps a "dictionary" of the distinct ages, in the order they first
+ *  appear, and stores each age as a one-byte code - its position in the
+ *  dictionary:
+ *
+ *      18 17 21 18 21   ->   dictionary 18 17 21,  codes 0 1 2 0 2
+ *
+ *  It also keeps how many times each dictionary age occurs.  count,
+ *  count_if, all_of and none_of then only look at the dictionary - a
+ *  handful of entries however many ages there are.  find and find_if test
+ *  the predicate once per dictionary entry, then scan the one-byte codes.
+ *  Iterating gives every age, in the original order.
+ *
+ *  At most 256 different ages can be stored: push_back() throws
+ *  out_of_range for a 257th, instead of silently mixing codes up.
+ *  Ages can be added and removed at the end only: push_back, pop_back
+ *  and clear.
+ */
+class DictionaryAges {
+public:
+    static constexpr std::size_t MAX_DISTINCT = 256;
+
+    // Random access iterator that looks each code up in the dictionary
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = int;
+
+        const_iterator() = default;
+        const_iterator(const std::uint8_t* p, const int* dict) : p(p), dict(dict) {}
+
+        int operator*() const { return dict[*p]; }
+        int operator[](difference_type n) const { return dict[p[n]]; }
+
+        const_iterator& operator++() { ++p; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++p; return old; }
+        const_iterator& operator--() { --p; return *this; }
+        const_iterator operator--(int) { const_iterator old = *this; --p; return old; }
+        const_iterator& operator+=(difference_type n) { p += n; return *this; }
+        const_iterator& operator-=(difference_type n) { p -= n; return *this; }
+
+        friend const_iterator operator+(const_iterator it, difference_type n) { return it += n; }
+        friend const_iterator operator+(difference_type n, const_iterator it) { return it += n; }
+        friend const_iterator operator-(const_iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const_iterator a, const_iterator b) { return a.p - b.p; }
+
+        bool operator==(const const_iterator& other) const { return p == other.p; }
+        auto operator<=>(const const_iterator& other) const { return p <=> other.p; }
+
+        const std::uint8_t* base() const { return p; }
+
+    private:
+        const std::uint8_t* p = nullptr;
+        const int* dict = nullptr;
+    };
+    using iterator = const_iterator;
+    using value_type = int;
+    using size_type = std::size_t;
+
+    DictionaryAges() = default;
+    DictionaryAges(std::initializer_list<int> ages)
+    {
+        for (int age : ages)
+            push_back(age);
+    }
+    explicit DictionaryAges(const std::vector<int>& ages)
+    {
+        codes.reserve(ages.size());
+        for (int age : ages)
+            push_back(age);
+    }
+
+    void push_back(int age)
+    {
+        // a linear search is quickest for the handful of entries we expect
+        size_type k = size_type(std::find(dict.begin(), dict.end(), age) - dict.begin());
+        if (k == dict.size()) {
+            if (dict.size() == MAX_DISTINCT)
+                throw std::out_of_range("DictionaryAges: age " + std::to_string(age) + " would be distinct age number "
+                                        + std::to_string(MAX_DISTINCT + 1));
+            dict.push_back(age);
+            counts.push_back(0);
+        }
+        codes.push_back(std::uint8_t(k));
+        ++counts[k];
+    }
+    void pop_back()
+    {
+        --counts[codes.back()];
+        codes.pop_back();
+    }
+    void clear()
+    {
+        codes.clear();
+        dict.clear();
+        counts.clear();
+    }
+    void reserve(size_type n) { codes.reserve(n); }
+
+    size_type size() const { return codes.size(); }
+    bool empty() const { return codes.empty(); }
+    int operator[](size_type i) const { return dict[codes[i]]; }
+    int at(size_type i) const { return dict[codes.at(i)]; }
+
+    const_iterator begin() const { return const_iterator(codes.data(), dict.data()); }
+    const_iterator end() const { return const_iterator(codes.data() + codes.size(), dict.data()); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // The dictionary: entry k is the age with code k.  An entry stays after
+    // its last age is popped, with a count of 0.
+    size_type distinct() const { return dict.size(); }
+    int dictionary_age(size_type k) const { return dict[k]; }
+    size_type dictionary_count(size_type k) const { return counts[k]; }
+
+    size_type memory_bytes() const
+    {
+        return codes.size() + dict.size() * sizeof(int) + counts.size() * sizeof(size_type);
+    }
+
+    std::ptrdiff_t count(int age) const { return count_if(pred::x == age); }
+
+    // Same as count_if(cbegin(), cend(), e) for a predicate from predicate.h
+    template <typename P>
+    std::ptrdiff_t count_if(const pred::Expr<P>& e) const
+    {
+        const P& p = e.self();
+        std::ptrdiff_t n = 0;
+        for (size_type k = 0; k < dict.size(); k++)
+            n += p(dict[k]) ? std::ptrdiff_t(counts[k]) : 0;
+        return n;
+    }
+
+    template <typename P>
+    bool none_of(const pred::Expr<P>& e) const { return count_if(e) == 0; }
+    template <typename P>
+    bool all_of(const pred::Expr<P>& e) const { return none_of(!e); }
+
+    const_iterator find(int age) const { return find_if(pred::x == age); }
+
+    template <typename P>
+    const_iterator find_if(const pred::Expr<P>& e) const
+    {
+        // which codes match - then the scan is a table lookup per byte
+        const P& p = e.self();
+        std::uint8_t match[MAX_DISTINCT] = {};
+        bool any = false;
+        for (size_type k = 0; k < dict.size(); k++) {
+            match[k] = p(dict[k]) && counts[k] > 0;
+            any |= match[k] != 0;
+        }
+        if (!any)
+            return end();
+        const std::uint8_t* first = codes.data();
+        const std::uint8_t* last = first + codes.size();
+        while (first != last && !match[*first])
+            ++first;
+        return const_iterator(first, dict.data());
+    }
+
+    // equal when they hold the same ages - the codes depend on the order ages first appeared
+    bool operator==(const DictionaryAges& other) const
+    {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+private:
+    std::vector<std::uint8_t> codes;        // one per age
+    std::vector<int> dict;                  // the age of each code
+    std::vector<size_type> counts;          // how many ages have each code
+};
+
+#endif //SAM206_ENCODED_AGES_H
@@ -0,0 +1,206 @@
+// lotto - compare lotto tickets against a draw using bit masks
+
+#include "lotto.h"
+
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAM206_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+TicketMask ticket_mask(const int* first, const int* last)
+{
+    if (last - first != LOTTO_NUMBERS)
+        throw invalid_argument("a lotto ticket has " + to_string(LOTTO_NUMBERS) + " numbers, not "
+                               + to_string(last - first));
+    TicketMask mask = 0;
+    for (; first != last; ++first) {
+        int number = *first;
+        if (number < 1 || number > LOTTO_MAX)
+            throw invalid_argument("lotto number " + to_string(number) + " is not in 1.."
+                                   + to_string(LOTTO_MAX));
+        TicketMask bit = TicketMask(1) << (number - 1);
+        if (mask & bit)
+            throw invalid_argument("lotto number " + to_string(number) + " appears twice");
+        mask |= bit;
+    }
+    return mask;
+}
+
+LottoTicket::LottoTicket(const int* first, const int* last)
+    : bits(ticket_mask(first, last))
+{
+    // reading the set bits from lowest to highest gives the numbers sorted
+    for (TicketMask rest = bits; rest != 0; rest &= rest - 1)
+        sorted[count++] = uint8_t(__builtin_ctzll(rest) + 1);
+}
+
+size_t count_duplicate_tickets(const vector<LottoTicket>& tickets)
+{
+    unordered_set<LottoTicket> seen;
+    seen.reserve(tickets.size());
+    size_t duplicates = 0;
+    for (const LottoTicket& ticket : tickets)
+        duplicates += !seen.insert(ticket).second;
+    return duplicates;
+}
+
+namespace {
+
+// Each kernel fills "tiers" and/or "matches", whichever is not null
+void score_scalar(const TicketMask* tickets, size_t n, TicketMask draw,
+                  PrizeTiers* tiers, uint8_t* matches)
+{
+    for (size_t i = 0; i < n; i++) {
+        int m = match_count(tickets[i], draw);
+        if (tiers)
+            tiers->tickets_matching[m]++;
+        if (matches)
+            matches[i] = uint8_t(m);
+    }
+}
+
+#ifdef SAM206_X86
+
+// popcount of each 64-bit lane, using a 16-entry table of 4-bit popcounts
+__attribute__((target("avx2")))
+__m256i popcount_epi64_avx2(__m256i v)
+{
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low4 = _mm256_set1_epi8(0x0F);
+    __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low4));
+    __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low4));
+    // add up the 8 byte counts of each 64-bit lane
+    return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2")))
+void score_avx2(const TicketMask* tickets, size_t n, TicketMask draw,
+                PrizeTiers* tiers, uint8_t* matches)
+{
+    const __m256i d = _mm256_set1_epi64x(static_cast<long long>(draw));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tickets + i));
+        __m256i pc = popcount_epi64_avx2(_mm256_and_si256(t, d));
+        if (tiers) {
+            for (int k = 0; k <= LOTTO_NUMBERS; k++) {
+                __m256i hit = _mm256_cmpeq_epi64(pc, _mm256_set1_epi64x(k));
+                tiers->tickets_matching[k] += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(hit)));
+            }
+        }
+        if (matches) {
+            alignas(32) long long lanes[4];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), pc);
+            for (int k = 0; k < 4; k++)
+                matches[i + k] = uint8_t(lanes[k]);
+        }
+    }
+    score_scalar(tickets + i, n - i, draw, tiers, matches ? matches + i : nullptr);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+void score_avx512(const TicketMask* tickets, size_t n, TicketMask draw,
+                  PrizeTiers* tiers, uint8_t* matches)
+{
+    const __m512i d = _mm512_set1_epi64(static_cast<long long>(draw));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i t = _mm512_loadu_si512(tickets + i);
+        __m512i pc = _mm512_popcnt_epi64(_mm512_and_si512(t, d));
+        if (tiers) {
+            for (int k = 0; k <= LOTTO_NUMBERS; k++) {
+                __mmask8 hit = _mm512_cmpeq_epi64_mask(pc, _mm512_set1_epi64(k));
+                tiers->tickets_matching[k] += __builtin_popcount(hit);
+            }
+        }
+        if (matches)    // keep the low byte of every 64-bit count
+            _mm512_mask_cvtepi64_storeu_epi8(matches + i, 0xFF, pc);
+    }
+    score_scalar(tickets + i, n - i, draw, tiers, matches ? matches + i : nullptr);
+}
+
+#endif // SAM206_X86
+
+using score_fn = void (*)(const TicketMask*, size_t, TicketMask, PrizeTiers*, uint8_t*);
+
+struct Kernel {
+    score_fn fn;
+    const char* name;
+};
+
+Kernel select_kernel()
+{
+#ifdef SAM206_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq"))
+        return {score_avx512, "avx512"};
+    if (__builtin_cpu_supports("avx2"))
+        return {score_avx2, "avx2"};
+#endif
+    return {score_scalar, "scalar"};
+}
+
+const Kernel& kernel()
+{
+    static const Kernel chosen = select_kernel();
+    return chosen;
+}
+
+// With at most LOTTO_NUMBERS bits in the draw, popcount(ticket & draw) is
+// always a valid index into tickets_matching, in every kernel
+void check_draw(TicketMask draw)
+{
+    if (__builtin_popcountll(draw) > LOTTO_NUMBERS)
+        throw invalid_argument("a lotto draw has at most " + to_string(LOTTO_NUMBERS) + " numbers, not "
+                               + to_string(__builtin_popcountll(draw)));
+}
+
+} // namespace
+
+PrizeTiers score_tickets(const TicketMask* tickets, size_t n, TicketMask draw)
+{
+    check_draw(draw);
+    PrizeTiers tiers;
+    kernel().fn(tickets, n, draw, &tiers, nullptr);
+    return tiers;
+}
+
+void match_counts(const TicketMask* tickets, size_t n, TicketMask draw, uint8_t* matches)
+{
+    check_draw(draw);
+    kernel().fn(tickets, n, draw, nullptr, matches);
+}
+
+bool score_tickets_using(const char* isa, const TicketMask* tickets, size_t n, TicketMask draw,
+                         PrizeTiers& tiers, uint8_t* matches)
+{
+    check_draw(draw);
+    string name = isa;
+    score_fn fn = nullptr;
+    if (name == "scalar")
+        fn = score_scalar;
+#ifdef SAM206_X86
+    __builtin_cpu_init();
+    if (name == "avx2" && __builtin_cpu_supports("avx2"))
+        fn = score_avx2;
+    if (name == "avx512" && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq"))
+        fn = score_avx512;
+#endif
+    if (!fn)
+        return false;
+    tiers = PrizeTiers();
+    fn(tickets, n, draw, &tiers, matches);
+    return true;
+}
+
+const char* lotto_isa()
+{
+    return kernel().name;
+}
@@ -0,0 +1,143 @@
+// lotto - compare lotto tickets against a draw using bit masks
+//
+// https://en.cppreference.com/w/cpp/numeric/popcount
+
+#ifndef SAM206_LOTTO_H
+#define SAM206_LOTTO_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+/**
+ *  Tickets as bit masks
+ *  "lottoDraw == myNumbers" in main.cpp only tells us whether two vectors
+ *  are identical.  To know how many numbers a ticket matched, each ticket
+ *  is stored as a 64-bit number with one bit per lotto number: bit 0 for
+ *  number 1, bit 1 for number 2, ... bit 63 for number 64.
+ *
+ *      ticket {2, 10, 13, 22, 35, 47}  ->  bits 1, 9, 12, 21, 34, 46 set
+ *
+ *  The numbers that a ticket and the draw have in common are then the bits
+ *  set in both (ticket & draw), and the number of matches is how many
+ *  bits that leaves set - popcount(ticket & draw).  The order of the
+ *  numbers on the ticket makes no difference.
+ */
+using TicketMask = std::uint64_t;
+
+constexpr int LOTTO_NUMBERS = 6;    // numbers on each ticket
+constexpr int LOTTO_MAX = 64;       // numbers are 1..LOTTO_MAX
+
+// Throw invalid_argument unless there are LOTTO_NUMBERS different numbers in 1..LOTTO_MAX
+TicketMask ticket_mask(const int* first, const int* last);
+
+inline TicketMask ticket_mask(const std::vector<int>& numbers)
+{
+    return ticket_mask(numbers.data(), numbers.data() + numbers.size());
+}
+
+inline TicketMask ticket_mask(std::initializer_list<int> numbers)
+{
+    return ticket_mask(numbers.begin(), numbers.end());
+}
+
+inline int match_count(TicketMask ticket, TicketMask draw)
+{
+    return __builtin_popcountll(ticket & draw);
+}
+
+/**
+ *  How many tickets matched 0, 1, ... 6 numbers: tickets_matching[k] is the
+ *  number of tickets with exactly k numbers in common with the draw.
+ */
+struct PrizeTiers {
+    std::array<std::size_t, LOTTO_NUMBERS + 1> tickets_matching{};
+};
+
+/**
+ * Score a whole array of tickets against one draw.
+ * Uses AVX-512 popcount, AVX2 or scalar code, chosen at runtime.
+ * A ticket can match no more numbers than the draw has, so a draw with
+ * more than LOTTO_NUMBERS numbers throws invalid_argument - it would have
+ * no tier to count into.
+ */
+PrizeTiers score_tickets(const TicketMask* tickets, std::size_t n, TicketMask draw);
+
+inline PrizeTiers score_tickets(const std::vector<TicketMask>& tickets, TicketMask draw)
+{
+    return score_tickets(tickets.data(), tickets.size(), draw);
+}
+
+// matches[i] = match_count(tickets[i], draw), for every ticket (same draw check)
+void match_counts(const TicketMask* tickets, std::size_t n, TicketMask draw, std::uint8_t* matches);
+
+// score_tickets() and match_counts() on one named code path, for tests that
+// compare the paths.  Returns false if this CPU cannot run that path.
+bool score_tickets_using(const char* isa, const TicketMask* tickets, std::size_t n, TicketMask draw,
+                         PrizeTiers& tiers, std::uint8_t* matches);
+
+// Name of the code path chosen at runtime: "avx512", "avx2" or "scalar"
+const char* lotto_isa();
+
+/**
+ *  LottoTicket
+ *  vector's operator== compares element by element, so {10,2,13,22,35,47}
+ *  is not equal to {2,10,13,22,35,47} although it is the same ticket.
+ *  A LottoTicket is "canonical": its numbers are kept sorted, so two
+ *  tickets with the same numbers are always equal however the numbers
+ *  were written.  It follows the same rule as ticket_mask() - exactly
+ *  LOTTO_NUMBERS different numbers in 1..LOTTO_MAX.
+ *
+ *  The numbers live inside the object (no heap memory), alongside the
+ *  ticket's bit mask.  Equality, match_count() and hashing only use the
+ *  mask - one comparison, one popcount, one multiply - with no loops and
+ *  no branches, so tickets work well as keys of an unordered_set.
+ *
+ *      LottoTicket(vector<int>{10,2,13,22,35,47}) == LottoTicket(vector<int>{2,10,13,22,35,47})   // true
+ */
+class LottoTicket {
+public:
+    LottoTicket() = default;
+
+    // Throws invalid_argument where ticket_mask() would
+    LottoTicket(const int* first, const int* last);
+    explicit LottoTicket(const std::vector<int>& numbers)
+        : LottoTicket(numbers.data(), numbers.data() + numbers.size()) {}
+    LottoTicket(std::initializer_list<int> numbers) : LottoTicket(numbers.begin(), numbers.end()) {}
+
+    TicketMask mask() const { return bits; }
+    int size() const { return count; }
+    int operator[](int i) const { return sorted[i]; }
+    const std::uint8_t* begin() const { return sorted.data(); }
+    const std::uint8_t* end() const { return sorted.data() + count; }
+
+    int match_count(const LottoTicket& draw) const { return ::match_count(bits, draw.bits); }
+
+    bool operator==(const LottoTicket& other) const { return bits == other.bits; }
+
+    std::size_t hash() const
+    {
+        // multiplying by a large odd constant mixes every bit into the high
+        // half; folding that back down spreads it over the low bits as well
+        std::uint64_t h = bits * 0x9E3779B97F4A7C15ull;
+        return std::size_t(h ^ (h >> 32));
+    }
+
+private:
+    TicketMask bits = 0;
+    std::array<std::uint8_t, LOTTO_NUMBERS> sorted{};
+    std::uint8_t count = 0;
+};
+
+template <>
+struct std::hash<LottoTicket> {
+    std::size_t operator()(const LottoTicket& ticket) const noexcept { return ticket.hash(); }
+};
+
+// How many tickets are repeats of an earlier ticket in the list
+std::size_t count_duplicate_tickets(const std::vector<LottoTicket>& tickets);
+
+#endif //SAM206_LOTTO_H
@@ -2,9 +2,17 @@
 //
 // https://en.cppreference.com/w/cpp/container/vector
 
+#include <cstdlib>
 #include <iostream>
 #include <vector>
-//#include <algorithm>
+#include <algorithm>
+#include "compact.h"
+#include "count_equal.h"
+#include "lotto.h"
+#include "output_buffer.h"
+#include "perf_counters.h"
+#include "predicate.h"
+#include "small_vector.h"
 using namespace std;
 
 /**
@@ -33,6 +41,13 @@ int main()
 {
     cout << "sam206 - vector - using Iterators" << endl;
 
+    // Each stage of main() is measured with the CPU's performance counters
+    // (see perf_counters.h): stage.next("...") ends one stage and starts the
+    // next.  Run with the environment variable SAM206_PERF set (for example
+    // "SAM206_PERF=1 ./sam206") to print the report to cerr at the end.
+    StageReport perf_report;
+    ScopedStage stage(perf_report, "populate_vector");
+
     // Create a vector called "ages_vector" to store the ages of students in a class.
     // The "ages_vector" is an object that is of type "vector of int".
 
@@ -40,8 +55,11 @@ int main()
 
     populate_vector(ages_vector);
 
+    stage.next("display");
     display(ages_vector);
 
+    stage.next("iterate");
+
     // Let's say we want to use an iterator to iterate across (move across) each
     // element in the vector and print out each element.
     // We use the function begin(), to get an iterator that initially points
@@ -93,6 +111,7 @@ int main()
 
     // Use the count() function from <algorithm> library to count elements in vector
     // Let's count the number of ages in the vector that are = 18
+    stage.next("count");
     int age = 21;
 
     // the count() function requires us to pass in two iterators :
@@ -100,7 +119,12 @@ int main()
     // an iterator pointing at then end of where we want to search in the vector.
     // https://cplusplus.com/reference/algorithm/count/
 
-    int num_items = count(ages_vector.cbegin(), ages_vector.cend(), age);  // counts all matches (=18) from beginning to end of vector
+    //    int num_items = count(ages_vector.cbegin(), ages_vector.cend(), age);  // counts all matches (=18) from beginning to end of vector
+    //
+    // count_equal() (see count_equal.h) gives the same answer as count(), but
+    // compares many ints at once using the CPU's SIMD instructions.
+    // On very large vectors it runs as fast as memory can deliver the data.
+    int num_items = count_equal(ages_vector, age);
     cout << "Count of students aged " << age << " = " << num_items << endl;
 
     // use the count_if() function from <algorithm> library
@@ -109,10 +133,17 @@ int main()
     // and returns a boolean value (true or false)
     // https://cplusplus.com/reference/algorithm/
 
-    int count_under18 = count_if(ages_vector.begin(), ages_vector.end(), [] (int i) { return i < 18; } );
+    stage.next("count_if");
+    //    count_if(ages_vector.begin(), ages_vector.end(), [] (int i) { return i < 18; } );
+    // The pred::count_if() version below takes the same predicate written as
+    // the expression "pred::x < 18" (see predicate.h).  The compiler sees the
+    // whole test at compile time, so it can check many elements at once.
+
+    int count_under18 = pred::count_if(ages_vector.begin(), ages_vector.end(), pred::x < 18);
     cout << "Count of students aged under 18 = " << count_under18 << '\n';
 
     // remove the last element in a vector
+    stage.next("pop_back");
     if( !ages_vector.empty() )
     {
         ages_vector.pop_back();   // removes the last element from a vector
@@ -124,6 +155,7 @@ int main()
     // This operation is usually expensive (unless removing only the end element(s))
     //
 
+    stage.next("erase third element");
     cout << "Vector content before erasing the third element" << endl;
     display(ages_vector);
     ages_vector.erase( ages_vector.begin() + 2 );  // removes the third element in the vector
@@ -131,6 +163,7 @@ int main()
     display(ages_vector);
 
 
+    stage.next("re-populate");
     cout << "Re-populating vector:";
     populate_vector(ages_vector);
     display(ages_vector);
@@ -144,17 +177,25 @@ int main()
     // points to the element directly after the one that was removed. So, we
     // use this iterator to continue in our for loop.
     //
+    //    for ( vector<int>::iterator iter = ages_vector.begin(); iter != ages_vector.end();  )
+    //    {
+    //        if (*iter % 2 == 0)
+    //            iter = ages_vector.erase(iter);  // remove element & obtain new iterator
+    //        else
+    //            ++iter;
+    //    }
+    //
+    // However, every erase() moves ALL of the later elements down by one, so
+    // on a large vector this loop is very slow.  erase_matching() (see compact.h)
+    // removes every matching element in one pass, keeping the order of the rest.
+    //
+    stage.next("erase even elements");
     cout << "Iterating over vector to remove EVEN elements" << endl;
-    for ( vector<int>::iterator iter = ages_vector.begin(); iter != ages_vector.end();  )
-    {
-        if (*iter % 2 == 0)
-            iter = ages_vector.erase(iter);  // remove element & obtain new iterator
-        else
-            ++iter;
-    }
+    erase_matching(ages_vector, [](int i){ return i % 2 == 0; });
     cout << "After removal of even elements vector contains : " ;
     display(ages_vector);
 
+    stage.next("re-populate");
     cout << "Re-populating vector:";
     populate_vector(ages_vector);
     display(ages_vector);
@@ -167,13 +208,17 @@ int main()
     // lambda predicate "i>16".
     // all_of() returns true if all of the ages are > 16.
     //
-    if ( all_of( ages_vector.cbegin(), ages_vector.cend(), [](int i){ return i > 16; } ) )
+    // (same as  all_of( ages_vector.cbegin(), ages_vector.cend(), [](int i){ return i > 16; } ) )
+    //
+    stage.next("all_of");
+    if ( pred::all_of( ages_vector.cbegin(), ages_vector.cend(), pred::x > 16 ) )
         cout << "all_of() : All values in ages_vector are greater than 16\n";
     else
         cout << "all_of() : One or more values are not greater than 16" << endl;
 
     // Use case : check to see if it is true that none of the students are under 17
-    if ( none_of(ages_vector.cbegin(), ages_vector.cend(), [](int i){ return i < 17; }) )
+    stage.next("none_of");
+    if ( pred::none_of(ages_vector.cbegin(), ages_vector.cend(), pred::x < 17) )
         cout << "none_of() : None of the values in vector are less than 17\n";
     else
         cout << "none_of() : One or more values are less than 17" << endl;
@@ -183,6 +228,7 @@ int main()
     // If the element was not found, the iterator will be equal to the end() iterator
     // If found, the iterator will be pointing at the first matching element.
     //
+    stage.next("find");
     cout << "Using find() to find value 17 in the vector." << endl;
     auto result_iter1 = find( begin(ages_vector), end(ages_vector), 17 ); // call find() to find 17
 
@@ -199,9 +245,15 @@ int main()
     // test each element to see if it is even.
     // (is_even is a pointer to a function - we will discuss later)
     //
-    auto is_even = [](int i){ return i%2 == 0; };   // define a lambda function and store in variable
+    //    auto is_even = [](int i){ return i%2 == 0; };   // define a lambda function and store in variable
+    //
+    // Here is_even is the predicate expression "pred::mod<2> == 0", which
+    // does the same test, and can still be called like a lambda: is_even(18)
+    //
+    stage.next("find_if");
+    auto is_even = pred::mod<2> == 0;
 
-    auto result_iter2 = find_if( begin(ages_vector), end(ages_vector), is_even ); // call find_if() to find elements that satisfy the is_even lambda
+    auto result_iter2 = pred::find_if( begin(ages_vector), end(ages_vector), is_even ); // call find_if() to find elements that satisfy the is_even lambda
 
     (result_iter2 != end(ages_vector))? cout << " found one value that satisfied the is_even lambda expression \n" : cout << "NO even values found" << endl;
 
@@ -210,32 +262,51 @@ int main()
     // In C++ these operators (e.g. ==) are OVERLOADED so that they work
     // correctly for vectors.  They compare the contents of two arrays.
 
-    vector<int> lottoDraw { 02,10,13,22,35,47 }; // initialization list
-    vector<int> myNumbers { 02,10,13,22,35,47 };
+    stage.next("lotto ==");
+    // A SmallVector (see small_vector.h) is used like a vector, but keeps up
+    // LOTTO_NUMBERS (6) numbers inside itself instead of asking the heap for memory.
+    SmallVector<int, LOTTO_NUMBERS> lottoDraw { 02,10,13,22,35,47 }; // initialization list
+    SmallVector<int, LOTTO_NUMBERS> myNumbers { 02,10,13,22,35,47 };
 
-    if( lottoDraw == myNumbers)
+    // Note that "lottoDraw == myNumbers" compares the numbers in order, so
+    // { 10,02,13,22,35,47 } would NOT be equal to the draw, even though it is
+    // the same ticket.  A LottoTicket (see lotto.h) keeps its numbers sorted,
+    // so comparing tickets gives the right answer in any order.
+
+    if( LottoTicket(lottoDraw.begin(), lottoDraw.end()) == LottoTicket(myNumbers.begin(), myNumbers.end()) )
         cout << "Horray, I have won the lotto" << endl;
     else
     cout << "No luck today" << endl;
 
+    stage.finish();
+
     cout << "Program finished - goodbye." << endl;
+    if (getenv("SAM206_PERF"))
+        perf_report.print(cerr);
 }
 
 /**
  * Display the elements in a vector of integers.
  * @param vector_ref is a reference to a 'constant vector of int'
  * - a reference is an alias - another name for the vector 'ages_vector' in this case.
+ *
+ * The simple version writes each element with "cout <<":
+ *      for (int i=0; i<vector_ref.size(); i++)
+ *      {
+ *          if (i != 0) {
+ *              cout << ",";
+ *          }
+ *          cout << vector_ref.at(i);
+ *      }
+ *      cout << endl;
+ * Here an OutputBuffer (see output_buffer.h) formats the numbers into one
+ * buffer that is reused on every call, and hands it to cout in large chunks.
+ * The output is exactly the same, and is flushed at the end, like endl.
  */
 void display(const vector<int>& vector_ref)
 {
-    for (int i=0; i<vector_ref.size(); i++)
-    {
-        if (i != 0) {
-            cout << ",";
-        }
-        cout << vector_ref.at(i);
-    }
-    cout << endl;
+    static OutputBuffer out(cout, FlushPolicy::EveryLine);
+    out.write_list(vector_ref);
 }
 
 void populate_vector( vector<int>& vect){
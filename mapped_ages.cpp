@@ -0,0 +1,96 @@
+// mapped_ages - read ages straight from a file mapped into memory
+
+#include "mapped_ages.h"
+
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+runtime_error system_error_for(const string& what, const string& path)
+{
+    return runtime_error(what + " " + path + ": " + strerror(errno));
+}
+}
+
+MappedAges::MappedAges(const string& path)
+{
+    static_assert(endian::native == endian::little,
+                  "the file holds little-endian ints, which are used without copying");
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw system_error_for("cannot open", path);
+
+    struct stat info {};
+    if (fstat(fd, &info) != 0) {
+        runtime_error error = system_error_for("cannot stat", path);
+        close(fd);
+        throw error;
+    }
+    mapped_bytes = size_type(info.st_size);
+    if (mapped_bytes % sizeof(int32_t) != 0) {
+        close(fd);
+        throw runtime_error(path + " is not a whole number of 4-byte ages");
+    }
+
+    if (mapped_bytes != 0) {    // mmap() refuses to map 0 bytes
+        mapping = mmap(nullptr, mapped_bytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+            runtime_error error = system_error_for("cannot map", path);
+            close(fd);
+            throw error;
+        }
+        // we normally read from front to back - ask the kernel to read ahead
+        madvise(mapping, mapped_bytes, MADV_SEQUENTIAL);
+        ages = static_cast<const int*>(mapping);
+        count = mapped_bytes / sizeof(int32_t);
+    }
+    close(fd);  // the mapping stays valid after the file is closed
+}
+
+MappedAges::~MappedAges()
+{
+    unmap();
+}
+
+MappedAges::MappedAges(MappedAges&& other) noexcept
+    : ages(exchange(other.ages, nullptr)),
+      count(exchange(other.count, 0)),
+      mapping(exchange(other.mapping, nullptr)),
+      mapped_bytes(exchange(other.mapped_bytes, 0))
+{
+}
+
+MappedAges& MappedAges::operator=(MappedAges&& other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        ages = exchange(other.ages, nullptr);
+        count = exchange(other.count, 0);
+        mapping = exchange(other.mapping, nullptr);
+        mapped_bytes = exchange(other.mapped_bytes, 0);
+    }
+    return *this;
+}
+
+void MappedAges::unmap()
+{
+    if (mapping)
+        munmap(mapping, mapped_bytes);
+    ages = nullptr;
+    count = 0;
+    mapping = nullptr;
+    mapped_bytes = 0;
+}
@@ -0,0 +1,63 @@
+// mapped_ages - read ages straight from a file mapped into memory
+//
+// https://man7.org/linux/man-pages/man2/mmap.2.html
+
+#ifndef SAM206_MAPPED_AGES_H
+#define SAM206_MAPPED_AGES_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ *  MappedAges
+ *  A read-only view of a binary ages file (4-byte little-endian ints, as
+ *  written by save_ages_binary() in age_loader.h).  Instead of copying the
+ *  ages into a vector<int>, the file is mapped into memory with mmap():
+ *  the operating system loads each page of the file the first time it is
+ *  read, so opening even a 4 GB file is almost instant, and processes that
+ *  map the same file share the same physical memory.
+ *
+ *  The iterators are plain "const int*", so the code in main.cpp works on
+ *  it unchanged:
+ *      MappedAges ages("ages.bin");
+ *      count(ages.cbegin(), ages.cend(), 21);
+ *      find_if(begin(ages), end(ages), is_even);
+ *
+ *  The constructor throws runtime_error if the file cannot be mapped.
+ *  A MappedAges can be moved but not copied - it owns the mapping.
+ */
+class MappedAges {
+public:
+    using value_type = int;
+    using const_iterator = const int*;
+    using iterator = const_iterator;
+    using size_type = std::size_t;
+
+    explicit MappedAges(const std::string& path);
+    ~MappedAges();
+
+    MappedAges(MappedAges&& other) noexcept;
+    MappedAges& operator=(MappedAges&& other) noexcept;
+    MappedAges(const MappedAges&) = delete;
+    MappedAges& operator=(const MappedAges&) = delete;
+
+    size_type size() const { return count; }
+    bool empty() const { return count == 0; }
+    const int* data() const { return ages; }
+    int operator[](size_type i) const { return ages[i]; }
+
+    const_iterator begin() const { return ages; }
+    const_iterator end() const { return ages + count; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+private:
+    void unmap();
+
+    const int* ages = nullptr;
+    size_type count = 0;
+    void* mapping = nullptr;
+    size_type mapped_bytes = 0;
+};
+
+#endif //SAM206_MAPPED_AGES_H
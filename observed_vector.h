@@ -0,0 +1,167 @@
+// observed_vector - a vector of int that keeps its statistics up to date
+//
+// https://en.cppreference.com/w/cpp/container/map
+
+#ifndef SAM206_OBSERVED_VECTOR_H
+#define SAM206_OBSERVED_VECTOR_H
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ *  ObservedVector
+ *  Each query in main() (count_if, all_of, none_of ...) reads the whole
+ *  vector again, even when the vector has not changed.  ObservedVector
+ *  instead updates its answers a little on every change - push_back,
+ *  pop_back, erase, set, clear - so reading them costs O(1):
+ *
+ *      sum(), min(), max(), even_count(), odd_count()
+ *      count_matching(id), all_of(id), none_of(id)  for predicates
+ *                                                   registered with watch()
+ *
+ *      ObservedVector ages_vector;
+ *      auto under18 = ages_vector.watch([](int i){ return i < 18; });
+ *      auto over16  = ages_vector.watch([](int i){ return i > 16; });
+ *      ... push_back / erase ...
+ *      ages_vector.count_matching(under18);     // count_if(... i < 18)
+ *      ages_vector.all_of(over16);              // all_of(... i > 16)
+ *
+ *  Each change costs O(number of watched predicates + log(distinct values)).
+ *  The elements can be read through const iterators, but only changed
+ *  through the member functions, so the statistics can never go stale.
+ */
+class ObservedVector {
+public:
+    using value_type = int;
+    using size_type = std::size_t;
+    using const_iterator = std::vector<int>::const_iterator;
+    using iterator = const_iterator;
+    using WatchId = std::size_t;
+
+    ObservedVector() = default;
+    ObservedVector(std::initializer_list<int> values)
+    {
+        for (int v : values)
+            push_back(v);
+    }
+
+    // Start counting the elements that satisfy pred - O(n) once, then kept up to date
+    WatchId watch(std::function<bool(int)> pred)
+    {
+        Watch w{std::move(pred), 0};
+        for (int v : values)
+            w.matching += w.pred(v);
+        watches.push_back(std::move(w));
+        return watches.size() - 1;
+    }
+
+    void push_back(int v)
+    {
+        values.push_back(v);
+        added(v);
+    }
+    void pop_back()
+    {
+        removed(values.back());
+        values.pop_back();
+    }
+    const_iterator erase(const_iterator pos)
+    {
+        removed(*pos);
+        return values.erase(pos);
+    }
+    const_iterator erase(const_iterator first, const_iterator last)
+    {
+        for (const_iterator it = first; it != last; ++it)
+            removed(*it);
+        return values.erase(first, last);
+    }
+    void set(size_type i, int v)
+    {
+        removed(values.at(i));
+        values[i] = v;
+        added(v);
+    }
+    void clear()
+    {
+        values.clear();
+        total = 0;
+        evens = 0;
+        value_counts.clear();
+        for (Watch& w : watches)
+            w.matching = 0;
+    }
+    void reserve(size_type n) { values.reserve(n); }
+
+    size_type size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+    int operator[](size_type i) const { return values[i]; }
+    int at(size_type i) const { return values.at(i); }
+    const std::vector<int>& vector() const { return values; }
+
+    const_iterator begin() const { return values.cbegin(); }
+    const_iterator end() const { return values.cend(); }
+    const_iterator cbegin() const { return values.cbegin(); }
+    const_iterator cend() const { return values.cend(); }
+
+    long long sum() const { return total; }
+    size_type even_count() const { return evens; }
+    size_type odd_count() const { return values.size() - evens; }
+
+    // smallest / largest element - throws out_of_range when empty
+    int min() const
+    {
+        if (value_counts.empty())
+            throw std::out_of_range("ObservedVector::min() of an empty vector");
+        return value_counts.begin()->first;
+    }
+    int max() const
+    {
+        if (value_counts.empty())
+            throw std::out_of_range("ObservedVector::max() of an empty vector");
+        return value_counts.rbegin()->first;
+    }
+
+    size_type count_matching(WatchId id) const { return watches.at(id).matching; }
+    bool all_of(WatchId id) const { return count_matching(id) == values.size(); }
+    bool none_of(WatchId id) const { return count_matching(id) == 0; }
+    bool any_of(WatchId id) const { return count_matching(id) != 0; }
+
+private:
+    struct Watch {
+        std::function<bool(int)> pred;
+        size_type matching;
+    };
+
+    void added(int v)
+    {
+        total += v;
+        evens += (v % 2 == 0);
+        ++value_counts[v];
+        for (Watch& w : watches)
+            w.matching += w.pred(v);
+    }
+    void removed(int v)
+    {
+        total -= v;
+        evens -= (v % 2 == 0);
+        auto it = value_counts.find(v);
+        if (--it->second == 0)
+            value_counts.erase(it);
+        for (Watch& w : watches)
+            w.matching -= w.pred(v);
+    }
+
+    std::vector<int> values;
+    long long total = 0;
+    size_type evens = 0;
+    std::map<int, size_type> value_counts;  // how many times each value occurs, for min/max
+    std::vector<Watch> watches;
+};
+
+#endif //SAM206_OBSERVED_VECTOR_H
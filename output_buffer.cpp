@@ -0,0 +1,75 @@
+// output_buffer - fast, buffered text output of numbers
+
+#include "output_buffer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+using namespace std;
+
+namespace {
+// longest int in text: "-2147483648"
+constexpr size_t MAX_INT_CHARS = numeric_limits<int>::digits10 + 2;
+}
+
+OutputBuffer::OutputBuffer(ostream& os, FlushPolicy policy, size_t capacity)
+    : os(os), policy(policy), buffer(capacity < MAX_INT_CHARS ? MAX_INT_CHARS : capacity)
+{
+}
+
+OutputBuffer::~OutputBuffer()
+{
+    flush();
+}
+
+void OutputBuffer::write(string_view text)
+{
+    while (!text.empty()) {
+        if (used == buffer.size())
+            drain();
+        size_t n = min(text.size(), buffer.size() - used);
+        text.copy(buffer.data() + used, n);
+        used += n;
+        text.remove_prefix(n);
+    }
+}
+
+void OutputBuffer::write(int value)
+{
+    if (buffer.size() - used < MAX_INT_CHARS)
+        drain();
+    char* start = buffer.data() + used;
+    auto result = to_chars(start, start + MAX_INT_CHARS, value);
+    used += size_t(result.ptr - start);
+}
+
+void OutputBuffer::end_line()
+{
+    put('\n');
+    if (policy == FlushPolicy::EveryLine)
+        flush();
+}
+
+void OutputBuffer::write_list(const int* first, const int* last, char separator)
+{
+    for (const int* p = first; p != last; ++p) {
+        if (p != first)
+            put(separator);
+        write(*p);
+    }
+    end_line();
+}
+
+void OutputBuffer::flush()
+{
+    drain();
+    os.flush();
+}
+
+void OutputBuffer::drain()
+{
+    if (used != 0)
+        os.write(buffer.data(), streamsize(used));
+    used = 0;
+}
@@ -0,0 +1,75 @@
+// output_buffer - fast, buffered text output of numbers
+//
+// https://en.cppreference.com/w/cpp/utility/to_chars
+
+#ifndef SAM206_OUTPUT_BUFFER_H
+#define SAM206_OUTPUT_BUFFER_H
+
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+/**
+ *  When is the buffered text handed to the stream (and the stream flushed)?
+ *  WhenFull  - only when the buffer is full, or flush() is called
+ *  EveryLine - also at the end of every line, like writing "endl"
+ */
+enum class FlushPolicy { WhenFull, EveryLine };
+
+/**
+ *  OutputBuffer
+ *  Writing "cout << value" for every element goes through the stream's
+ *  formatting machinery each time.  OutputBuffer instead formats numbers
+ *  with to_chars() straight into its own buffer, and passes the text to the
+ *  stream in large chunks.  The buffer is allocated once, in the
+ *  constructor - writing never allocates memory.
+ *
+ *      OutputBuffer out(cout, FlushPolicy::EveryLine);
+ *      out.write_list(ages_vector);     // prints 18,17,21,18,21 and a newline
+ */
+class OutputBuffer {
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    explicit OutputBuffer(std::ostream& os,
+                          FlushPolicy policy = FlushPolicy::WhenFull,
+                          std::size_t capacity = DEFAULT_CAPACITY);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void put(char c)
+    {
+        if (used == buffer.size())
+            drain();
+        buffer[used++] = c;
+    }
+    void write(std::string_view text);
+    void write(int value);
+
+    // Ends the current line - with FlushPolicy::EveryLine this also flushes
+    void end_line();
+
+    // Writes the elements separated by "separator", then ends the line.
+    // The output is the same as the display() function in main.cpp.
+    void write_list(const int* first, const int* last, char separator = ',');
+    void write_list(const std::vector<int>& vect, char separator = ',')
+    {
+        write_list(vect.data(), vect.data() + vect.size(), separator);
+    }
+
+    // Hands everything buffered to the stream, and flushes the stream
+    void flush();
+
+private:
+    void drain();   // hands the buffered text to the stream, without flushing it
+
+    std::ostream& os;
+    FlushPolicy policy;
+    std::vector<char> buffer;
+    std::size_t used = 0;
+};
+
+#endif //SAM206_OUTPUT_BUFFER_H
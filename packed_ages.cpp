@@ -0,0 +1,299 @@
+// packed_ages - ages stored in compressed, bit-packed segments
+
+#include "packed_ages.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <utility>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAM206_X86 1
+#endif
+
+using namespace std;
+
+namespace {
+
+constexpr size_t LANES = PackedAges::LANES;
+constexpr size_t ROWS = PackedAges::ROWS;
+
+constexpr uint32_t low_bits(unsigned bits)
+{
+    return bits >= 32 ? ~uint32_t(0) : (uint32_t(1) << bits) - 1;
+}
+
+// The 8 lanes of a row as one value.  GCC turns arithmetic on it into
+// one AVX2 instruction, or two SSE2 instructions in the default build.
+typedef uint32_t Lanes __attribute__((vector_size(LANES * sizeof(uint32_t))));
+
+/*
+ * Row r of a lane starts at bit r * B of that lane's stream: in word
+ * (r * B) / 32, at shift (r * B) % 32, and it may spill into the next word.
+ * Word w of every lane is in[w * LANES .. w * LANES + 7].  With B and R
+ * known at compile time every shift is a constant.  (The result is an
+ * out parameter: returning a Lanes by value draws an ABI warning.)
+ */
+template <unsigned B, unsigned R>
+[[gnu::always_inline]] inline void codes_of(const uint32_t* in, Lanes& codes)
+{
+    constexpr unsigned word = R * B / 32;
+    constexpr unsigned shift = R * B % 32;
+    if constexpr (B == 0) {
+        codes = Lanes{};        // every age is min - there are no words
+    } else {
+        memcpy(&codes, in + word * LANES, sizeof codes);
+        codes >>= shift;
+        if constexpr (shift + B > 32) {
+            Lanes next;
+            memcpy(&next, in + (word + 1) * LANES, sizeof next);
+            codes |= next << (32 - shift);
+        }
+        codes &= low_bits(B);
+    }
+}
+
+template <unsigned B, unsigned R>
+[[gnu::always_inline]] inline void unpack_row(const uint32_t* in, uint32_t base, int* out)
+{
+    Lanes ages;
+    codes_of<B, R>(in, ages);
+    ages += base;
+    memcpy(out + R * LANES, &ages, sizeof ages);
+}
+
+// Counts the codes in lo .. lo+width with one unsigned compare, like
+// pred::Between.  A compare gives -1 in a lane that matched, so
+// subtracting it adds one to that lane's counter.
+template <unsigned B, unsigned R>
+[[gnu::always_inline]] inline void count_row(const uint32_t* in, uint32_t lo, uint32_t width, Lanes& counts)
+{
+    Lanes codes;
+    codes_of<B, R>(in, codes);
+    counts -= Lanes(codes - lo <= width);
+}
+
+// 32 rows of B bits fill exactly B words per lane, so the shifts repeat
+// every 32 rows: unpack 32 rows, move on B words, and again
+template <unsigned B, unsigned... R>
+[[gnu::always_inline]] inline void unpack_body(const uint32_t* in, int min, int* out,
+                                               integer_sequence<unsigned, R...>)
+{
+    const uint32_t base = uint32_t(min);
+    for (size_t group = 0; group < ROWS / 32; group++) {
+        (unpack_row<B, R>(in, base, out), ...);
+        in += B * LANES;
+        out += 32 * LANES;
+    }
+}
+
+template <unsigned B, unsigned... R>
+[[gnu::always_inline]] inline unsigned count_body(const uint32_t* in, uint32_t lo, uint32_t width,
+                                                  integer_sequence<unsigned, R...>)
+{
+    Lanes counts{};
+    for (size_t group = 0; group < ROWS / 32; group++) {
+        (count_row<B, R>(in, lo, width, counts), ...);
+        in += B * LANES;
+    }
+    unsigned n = 0;
+    for (size_t l = 0; l < LANES; l++)
+        n += counts[l];
+    return n;
+}
+
+using unpack_fn = void (*)(const uint32_t*, int, int*);
+using count_fn = unsigned (*)(const uint32_t*, uint32_t, uint32_t);
+
+// one unpack and one count function for each width 0..32
+struct Kernel {
+    array<unpack_fn, 33> unpack;
+    array<count_fn, 33> count;
+    const char* name;
+};
+
+template <unsigned B>
+void unpack_scalar(const uint32_t* in, int min, int* out)
+{
+    unpack_body<B>(in, min, out, make_integer_sequence<unsigned, 32>{});
+}
+
+template <unsigned B>
+unsigned count_scalar(const uint32_t* in, uint32_t lo, uint32_t width)
+{
+    return count_body<B>(in, lo, width, make_integer_sequence<unsigned, 32>{});
+}
+
+template <size_t... B>
+constexpr Kernel scalar_kernel(index_sequence<B...>)
+{
+    return {{unpack_scalar<B>...}, {count_scalar<B>...}, "scalar"};
+}
+
+#ifdef SAM206_X86
+
+template <unsigned B>
+__attribute__((target("avx2")))
+void unpack_avx2(const uint32_t* in, int min, int* out)
+{
+    unpack_body<B>(in, min, out, make_integer_sequence<unsigned, 32>{});
+}
+
+template <unsigned B>
+__attribute__((target("avx2")))
+unsigned count_avx2(const uint32_t* in, uint32_t lo, uint32_t width)
+{
+    return count_body<B>(in, lo, width, make_integer_sequence<unsigned, 32>{});
+}
+
+template <size_t... B>
+constexpr Kernel avx2_kernel(index_sequence<B...>)
+{
+    return {{unpack_avx2<B>...}, {count_avx2<B>...}, "avx2"};
+}
+
+#endif // SAM206_X86
+
+Kernel select_kernel()
+{
+#ifdef SAM206_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return avx2_kernel(make_index_sequence<33>{});
+#endif
+    return scalar_kernel(make_index_sequence<33>{});
+}
+
+const Kernel& kernel()
+{
+    static const Kernel chosen = select_kernel();  // resolved once, thread-safe
+    return chosen;
+}
+
+} // namespace
+
+void PackedAges::pack(const int* ages)
+{
+    int lo = ages[0], hi = ages[0];
+    for (size_t i = 1; i < SEGMENT; i++) {
+        lo = ages[i] < lo ? ages[i] : lo;
+        hi = ages[i] > hi ? ages[i] : hi;
+    }
+    const unsigned bits = unsigned(bit_width(uint32_t(hi) - uint32_t(lo)));
+    const size_t offset = words.size();
+    words.resize(offset + bits * ROWS * LANES / 32, 0);
+
+    uint32_t* out = words.data() + offset;
+    for (size_t r = 0; bits > 0 && r < ROWS; r++) {
+        const size_t word = r * bits / 32;
+        const unsigned shift = r * bits % 32;
+        for (size_t l = 0; l < LANES; l++) {
+            const uint32_t code = uint32_t(ages[r * LANES + l]) - uint32_t(lo);
+            out[word * LANES + l] |= code << shift;
+            if (shift + bits > 32)
+                out[(word + 1) * LANES + l] |= code >> (32 - shift);
+        }
+    }
+    segs.push_back({lo, hi, bits, offset});
+}
+
+void PackedAges::decode(size_type s, int* out) const
+{
+    const Segment& seg = segs[s];
+    kernel().unpack[seg.bits](words.data() + seg.offset, seg.min, out);
+}
+
+int PackedAges::operator[](size_type i) const
+{
+    const size_type s = i / SEGMENT;
+    if (s >= segs.size())
+        return tail[i - segs.size() * SEGMENT];
+
+    const Segment& seg = segs[s];
+    const size_t r = i % SEGMENT / LANES, l = i % LANES;
+    const size_t word = r * seg.bits / 32;
+    const unsigned shift = r * seg.bits % 32;
+    const uint32_t* in = words.data() + seg.offset;
+    uint32_t code = 0;
+    if (seg.bits > 0) {
+        code = in[word * LANES + l] >> shift;
+        if (shift + seg.bits > 32)
+            code |= in[(word + 1) * LANES + l] << (32 - shift);
+    }
+    return int((code & low_bits(seg.bits)) + uint32_t(seg.min));
+}
+
+/*
+ * The ages of segment s in [r.lo, r.hi].  Clipped to the segment's own
+ * min..max, the interval either misses the segment, covers all of it, or
+ * becomes the codes lo .. lo+width - only then are the codes read.
+ */
+unsigned PackedAges::count_inside(size_type s, const pred::Range& r) const
+{
+    const Segment& seg = segs[s];
+    const int lo = r.lo > seg.min ? r.lo : seg.min;
+    const int hi = r.hi < seg.max ? r.hi : seg.max;
+    if (lo > hi)
+        return 0;
+    if (lo == seg.min && hi == seg.max)
+        return SEGMENT;
+    return kernel().count[seg.bits](words.data() + seg.offset, uint32_t(lo) - uint32_t(seg.min),
+                                    uint32_t(hi) - uint32_t(lo));
+}
+
+ptrdiff_t PackedAges::count_in(const pred::Range& r) const
+{
+    ptrdiff_t n = 0;
+    for (size_type s = 0; s < segs.size(); s++) {
+        unsigned inside = count_inside(s, r);
+        n += r.outside ? SEGMENT - inside : inside;
+    }
+    for (int age : tail)
+        n += r.contains(age);
+    return n;
+}
+
+// Counting a segment is cheap, so find() counts until a segment has a
+// match, and only then reads that segment's ages one at a time
+PackedAges::size_type PackedAges::find_in(const pred::Range& r) const
+{
+    for (size_type s = 0; s < segs.size(); s++) {
+        unsigned inside = count_inside(s, r);
+        if (r.outside ? inside == SEGMENT : inside == 0)
+            continue;
+        for (size_type i = s * SEGMENT;; i++)
+            if (r.contains((*this)[i]))
+                return i;
+    }
+    for (size_type i = 0; i < tail.size(); i++)
+        if (r.contains(tail[i]))
+            return segs.size() * SEGMENT + i;
+    return size();
+}
+
+void PackedAges::pop_back()
+{
+    if (tail.empty()) {
+        // unpack the last segment so its ages can be removed one at a time
+        tail.resize(SEGMENT);
+        decode(segs.size() - 1, tail.data());
+        words.resize(segs.back().offset);
+        segs.pop_back();
+    }
+    tail.pop_back();
+}
+
+vector<int> PackedAges::to_vector() const
+{
+    vector<int> ages(size());
+    for (size_type s = 0; s < segs.size(); s++)
+        decode(s, ages.data() + s * SEGMENT);
+    copy(tail.begin(), tail.end(), ages.begin() + segs.size() * SEGMENT);
+    return ages;
+}
+
+const char* packed_ages_isa()
+{
+    return kernel().name;
+}
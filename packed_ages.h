@@ -0,0 +1,248 @@
+// packed_ages - ages stored in compressed, bit-packed segments
+//
+// https://lemire.me/blog/2012/03/06/how-fast-is-bit-packing/
+
+#ifndef SAM206_PACKED_AGES_H
+#define SAM206_PACKED_AGES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "predicate.h"
+
+/**
+ *  PackedAges
+ *  Ages only span a small range, e.g. 16..30, yet vector<int> spends 32
+ *  bits on each one.  PackedAges stores them in segments of 1024:
+ *
+ *      min   the smallest age in the segment
+ *      bits  how many bits the largest "age - min" needs (0..32)
+ *      then every age as the "code" age - min, in exactly that many bits
+ *
+ *  Ages 16..30 give codes 0..14, which need 4 bits - an eighth of the
+ *  memory of a vector<int>, so a scan reads eight times fewer cache lines.
+ *  Ages 0..127 need 7 bits (4.6x smaller).  Any int can be stored; a wider
+ *  spread just needs more bits.
+ *
+ *  The codes are not written one after the other.  Age i of a segment goes
+ *  to "lane" i % 8, and each lane is its own stream of bits; the 32-bit
+ *  words of the 8 lanes are interleaved.  Unpacking then does exactly the
+ *  same shifts for all 8 lanes, so one SIMD instruction unpacks 8 ages.
+ *
+ *  New ages go into a small unpacked tail; each time it reaches 1024 ages
+ *  it is packed into a segment.  Ages cannot be changed once packed -
+ *  only push_back, pop_back and clear - so this suits data that is loaded
+ *  once and then queried many times.
+ *
+ *  count, count_if, find, find_if, all_of and none_of never turn the codes
+ *  back into ints when the predicate is an interval (see pred::range_of):
+ *  x < 18 in a segment with min 16 is the same test as code < 2, so the
+ *  constant is translated once per segment and the codes are compared as
+ *  they are shifted out of the words.  A segment whose min..max lies
+ *  wholly inside or outside the interval is not read at all.  Other
+ *  predicates, such as mod<2> == 0, unpack one segment at a time into a
+ *  buffer that stays in the L1 cache.
+ */
+class PackedAges {
+public:
+    static constexpr std::size_t SEGMENT = 1024;    // ages per segment
+    static constexpr std::size_t LANES = 8;
+    static constexpr std::size_t ROWS = SEGMENT / LANES;
+
+    // Random access iterator that unpacks each age it reads
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = int;
+
+        const_iterator() = default;
+        const_iterator(const PackedAges* ages, std::size_t i) : ages(ages), i(i) {}
+
+        int operator*() const { return (*ages)[i]; }
+        int operator[](difference_type n) const { return (*ages)[i + n]; }
+
+        const_iterator& operator++() { ++i; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++i; return old; }
+        const_iterator& operator--() { --i; return *this; }
+        const_iterator operator--(int) { const_iterator old = *this; --i; return old; }
+        const_iterator& operator+=(difference_type n) { i += n; return *this; }
+        const_iterator& operator-=(difference_type n) { i -= n; return *this; }
+
+        friend const_iterator operator+(const_iterator it, difference_type n) { return it += n; }
+        friend const_iterator operator+(difference_type n, const_iterator it) { return it += n; }
+        friend const_iterator operator-(const_iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const_iterator a, const_iterator b)
+        {
+            return difference_type(a.i) - difference_type(b.i);
+        }
+
+        bool operator==(const const_iterator& other) const { return i == other.i; }
+        auto operator<=>(const const_iterator& other) const { return i <=> other.i; }
+
+        std::size_t index() const { return i; }
+
+    private:
+        const PackedAges* ages = nullptr;
+        std::size_t i = 0;
+    };
+    using iterator = const_iterator;
+    using value_type = int;
+    using size_type = std::size_t;
+
+    PackedAges() = default;
+    PackedAges(std::initializer_list<int> ages)
+    {
+        for (int age : ages)
+            push_back(age);
+    }
+    explicit PackedAges(const std::vector<int>& ages)
+    {
+        for (int age : ages)
+            push_back(age);
+    }
+
+    void push_back(int age)
+    {
+        tail.push_back(age);
+        if (tail.size() == SEGMENT) {
+            pack(tail.data());
+            tail.clear();
+        }
+    }
+    void pop_back();
+    void clear()
+    {
+        segs.clear();
+        words.clear();
+        tail.clear();
+    }
+
+    size_type size() const { return segs.size() * SEGMENT + tail.size(); }
+    bool empty() const { return segs.empty() && tail.empty(); }
+
+    int operator[](size_type i) const;
+    int at(size_type i) const
+    {
+        if (i >= size())
+            throw std::out_of_range("PackedAges::at: index " + std::to_string(i)
+                                    + " >= size " + std::to_string(size()));
+        return (*this)[i];
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // The packed segments, and the ages not yet packed
+    size_type segments() const { return segs.size(); }
+    unsigned segment_bits(size_type s) const { return segs[s].bits; }
+    // Unpack segment s into out[0 .. SEGMENT)
+    void decode(size_type s, int* out) const;
+    std::vector<int> to_vector() const;
+
+    // Bytes used by the ages - compare with size() * sizeof(int) for a vector
+    size_type memory_bytes() const
+    {
+        return words.size() * sizeof(std::uint32_t) + segs.size() * sizeof(Segment)
+               + tail.size() * sizeof(int);
+    }
+
+    std::ptrdiff_t count(int age) const { return count_in(pred::Range{age, age, false}); }
+
+    // Same as count_if(cbegin(), cend(), e) for a predicate from predicate.h
+    template <typename P>
+    std::ptrdiff_t count_if(const pred::Expr<P>& e) const
+    {
+        if constexpr (pred::has_range<P>) {
+            if (std::optional<pred::Range> r = pred::range_of(e.self()))
+                return count_in(*r);
+        }
+        std::ptrdiff_t n = 0;
+        scan([&](const int* first, const int* last) {
+            n += pred::count_if(first, last, e);
+            return false;
+        });
+        return n;
+    }
+
+    const_iterator find(int age) const { return const_iterator(this, find_in(pred::Range{age, age, false})); }
+
+    template <typename P>
+    const_iterator find_if(const pred::Expr<P>& e) const
+    {
+        if constexpr (pred::has_range<P>) {
+            if (std::optional<pred::Range> r = pred::range_of(e.self()))
+                return const_iterator(this, find_in(*r));
+        }
+        std::ptrdiff_t found = 0;
+        size_type block = scan([&](const int* first, const int* last) {
+            const int* hit = pred::find_if(first, last, e);
+            found = hit - first;
+            return hit != last;
+        });
+        return const_iterator(this, block == size() ? block : block + size_type(found));
+    }
+
+    template <typename P>
+    bool none_of(const pred::Expr<P>& e) const { return find_if(e) == end(); }
+    template <typename P>
+    bool all_of(const pred::Expr<P>& e) const { return none_of(!e); }
+
+    bool operator==(const PackedAges& other) const
+    {
+        return size() == other.size() && to_vector() == other.to_vector();
+    }
+
+private:
+    struct Segment {
+        int min;
+        int max;
+        unsigned bits;
+        std::size_t offset;     // first word of the segment in "words"
+    };
+
+    void pack(const int* ages);
+
+    // count / find the ages that r accepts, working on the packed codes
+    unsigned count_inside(size_type s, const pred::Range& r) const;
+    std::ptrdiff_t count_in(const pred::Range& r) const;
+    size_type find_in(const pred::Range& r) const;
+
+    /*
+     * Unpack each segment in turn and call visit(first, last) on its ages;
+     * then visit the tail.  visit() returns true to stop the scan.  Returns
+     * the index of the first age of the block where the scan stopped, or
+     * size() if it did not stop.
+     */
+    template <typename Visit>
+    size_type scan(Visit visit) const
+    {
+        alignas(64) int buffer[SEGMENT];
+        for (size_type s = 0; s < segs.size(); s++) {
+            decode(s, buffer);
+            if (visit(buffer, buffer + SEGMENT))
+                return s * SEGMENT;
+        }
+        if (visit(tail.data(), tail.data() + tail.size()))
+            return segs.size() * SEGMENT;
+        return size();
+    }
+
+    std::vector<Segment> segs;
+    std::vector<std::uint32_t> words;   // the packed codes of every segment
+    std::vector<int> tail;              // fewer than SEGMENT ages, not packed yet
+};
+
+// Name of the unpacking code chosen at runtime: "avx2" or "scalar"
+const char* packed_ages_isa();
+
+#endif //SAM206_PACKED_AGES_H
@@ -0,0 +1,262 @@
+// parallel - multi-threaded versions of the algorithms used in main.cpp
+//
+// https://en.cppreference.com/w/cpp/algorithm/execution_policy_tag_t
+
+#ifndef SAM206_PARALLEL_H
+#define SAM206_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include "compact.h"
+#include "count_equal.h"
+#include "predicate.h"
+#include "thread_pool.h"
+
+/**
+ *  Parallel algorithms
+ *  par::count, count_if, all_of, none_of, any_of, find, find_if and
+ *  erase_matching give the same results as the <algorithm> functions (and
+ *  erase_matching() in compact.h), but split the vector into chunks that
+ *  are processed at the same time by the threads of a ThreadPool:
+ *
+ *      par::count_if(ages_vector.cbegin(), ages_vector.cend(), pred::x < 18);
+ *
+ *  Chunk boundaries fall on 64-byte cache lines, so no two threads ever
+ *  touch the same cache line.  There are a few chunks per thread, so a
+ *  thread that finishes early picks up another chunk.  Ranges smaller than
+ *  MIN_PARALLEL elements are processed by the calling thread alone - for
+ *  them, starting the other threads would cost more than it saves.
+ *
+ *  find() and find_if() return the FIRST match, as the <algorithm> ones do.
+ *  Once a match has been found, chunks further along the vector stop
+ *  searching, since they can only find later matches.
+ */
+namespace par {
+
+constexpr std::ptrdiff_t MIN_PARALLEL = 1 << 16;
+constexpr std::ptrdiff_t CACHE_LINE_INTS = 64 / sizeof(int);
+constexpr unsigned CHUNKS_PER_THREAD = 4;
+
+// Splits [first, last) into chunks whose inner boundaries are cache-line aligned
+class Chunks {
+public:
+    Chunks(const int* first, const int* last, unsigned threads) : first(first), n(last - first)
+    {
+        std::ptrdiff_t parts = std::max<std::ptrdiff_t>(1, std::min<std::ptrdiff_t>(
+            std::ptrdiff_t(threads) * CHUNKS_PER_THREAD, n / (MIN_PARALLEL / 4)));
+        step = (n + parts - 1) / parts;
+        step = std::max<std::ptrdiff_t>(1, (step + CACHE_LINE_INTS - 1) / CACHE_LINE_INTS) * CACHE_LINE_INTS;
+        // first + skew is the first element that starts a cache line
+        skew = std::ptrdiff_t((64 - std::uintptr_t(first) % 64) % 64 / sizeof(int));
+        std::ptrdiff_t rest = n - skew;
+        count = rest > step ? std::size_t((rest + step - 1) / step) : 1;
+    }
+
+    std::size_t size() const { return count; }
+    const int* begin(std::size_t i) const { return first + offset(i); }
+    const int* end(std::size_t i) const { return first + offset(i + 1); }
+
+private:
+    // chunk i starts at skew + i * step, except chunk 0, which starts at 0
+    std::ptrdiff_t offset(std::size_t i) const
+    {
+        if (i == 0)
+            return 0;
+        if (i >= count)
+            return n;
+        return std::min(n, skew + std::ptrdiff_t(i) * step);
+    }
+
+    const int* first;
+    std::ptrdiff_t n;
+    std::ptrdiff_t step;
+    std::ptrdiff_t skew;
+    std::size_t count;
+};
+
+template <typename Pred>
+std::ptrdiff_t count_if(const int* first, const int* last, Pred pred,
+                        ThreadPool& pool = ThreadPool::shared())
+{
+    auto count_chunk = [&](const int* b, const int* e) {
+        std::ptrdiff_t n = 0;
+        for (; b != e; ++b)
+            n += bool(pred(*b));
+        return n;
+    };
+    if (last - first < MIN_PARALLEL)
+        return count_chunk(first, last);
+
+    Chunks chunks(first, last, pool.size());
+    std::vector<std::ptrdiff_t> partial(chunks.size());
+    pool.run(chunks.size(), [&](std::size_t i) { partial[i] = count_chunk(chunks.begin(i), chunks.end(i)); });
+
+    std::ptrdiff_t n = 0;
+    for (std::ptrdiff_t p : partial)
+        n += p;
+    return n;
+}
+
+inline std::ptrdiff_t count(const int* first, const int* last, int value,
+                            ThreadPool& pool = ThreadPool::shared())
+{
+    if (last - first < MIN_PARALLEL)
+        return count_equal(first, last, value);
+
+    Chunks chunks(first, last, pool.size());
+    std::vector<std::ptrdiff_t> partial(chunks.size());
+    pool.run(chunks.size(), [&](std::size_t i) { partial[i] = count_equal(chunks.begin(i), chunks.end(i), value); });
+
+    std::ptrdiff_t n = 0;
+    for (std::ptrdiff_t p : partial)
+        n += p;
+    return n;
+}
+
+template <typename Pred>
+const int* find_if(const int* first, const int* last, Pred pred,
+                   ThreadPool& pool = ThreadPool::shared())
+{
+    if (last - first < MIN_PARALLEL)
+        return std::find_if(first, last, pred);
+
+    // index of the first match found so far (last - first = none yet)
+    std::atomic<std::ptrdiff_t> best(last - first);
+    constexpr std::ptrdiff_t CHECK_EVERY = 4096;
+
+    Chunks chunks(first, last, pool.size());
+    pool.run(chunks.size(), [&](std::size_t i) {
+        const int* b = chunks.begin(i);
+        const int* e = chunks.end(i);
+        while (b != e) {
+            // give up if an earlier chunk has already found a match
+            if (best.load(std::memory_order_relaxed) < b - first)
+                return;
+            const int* stop = b + std::min(CHECK_EVERY, e - b);
+            const int* hit = std::find_if(b, stop, pred);
+            if (hit != stop) {
+                std::ptrdiff_t index = hit - first;
+                std::ptrdiff_t current = best.load(std::memory_order_relaxed);
+                while (index < current && !best.compare_exchange_weak(current, index))
+                    ;
+                return;
+            }
+            b = stop;
+        }
+    });
+    return first + best.load();
+}
+
+inline const int* find(const int* first, const int* last, int value,
+                       ThreadPool& pool = ThreadPool::shared())
+{
+    return par::find_if(first, last, [value](int v) { return v == value; }, pool);
+}
+
+template <typename Pred>
+bool none_of(const int* first, const int* last, Pred pred, ThreadPool& pool = ThreadPool::shared())
+{
+    return par::find_if(first, last, pred, pool) == last;
+}
+
+template <typename Pred>
+bool any_of(const int* first, const int* last, Pred pred, ThreadPool& pool = ThreadPool::shared())
+{
+    return !par::none_of(first, last, pred, pool);
+}
+
+template <typename Pred>
+bool all_of(const int* first, const int* last, Pred pred, ThreadPool& pool = ThreadPool::shared())
+{
+    return par::none_of(first, last, [pred](int v) { return !pred(v); }, pool);
+}
+
+/**
+ * Parallel erase_matching(): every chunk is compacted by its own thread,
+ * then the kept parts of the chunks are moved down next to each other.
+ * @return how many elements were removed
+ */
+template <typename Pred>
+std::size_t erase_matching(std::vector<int>& vect, Pred pred, ThreadPool& pool = ThreadPool::shared())
+{
+    if (std::ptrdiff_t(vect.size()) < MIN_PARALLEL)
+        return ::erase_matching(vect, pred);
+
+    int* first = vect.data();
+    Chunks chunks(first, first + vect.size(), pool.size());
+    std::vector<int*> kept_end(chunks.size());
+    pool.run(chunks.size(), [&](std::size_t i) {
+        int* b = first + (chunks.begin(i) - first);
+        int* e = first + (chunks.end(i) - first);
+        kept_end[i] = compact_range(b, e, pred);
+    });
+
+    int* dst = kept_end[0];
+    for (std::size_t i = 1; i < chunks.size(); i++) {
+        const int* b = chunks.begin(i);
+        std::size_t n = std::size_t(kept_end[i] - b);
+        std::memmove(dst, b, n * sizeof(int));
+        dst += n;
+    }
+
+    std::size_t removed = vect.size() - std::size_t(dst - first);
+    vect.resize(std::size_t(dst - first));
+    return removed;
+}
+
+// Iterator versions, for vector<int> iterators and other contiguous ones
+template <pred::int_iterator It, typename Pred>
+std::ptrdiff_t count_if(It first, It last, Pred pred, ThreadPool& pool = ThreadPool::shared())
+{
+    const int* p = std::to_address(first);
+    return par::count_if(p, p + (last - first), pred, pool);
+}
+
+template <pred::int_iterator It>
+std::ptrdiff_t count(It first, It last, int value, ThreadPool& pool = ThreadPool::shared())
+{
+    const int* p = std::to_address(first);
+    return par::count(p, p + (last - first), value, pool);
+}
+
+template <pred::int_iterator It, typename Pred>
+It find_if(It first, It last, Pred pred, ThreadPool& pool = ThreadPool::shared())
+{
+    const int* p = std::to_address(first);
+    return first + (par::find_if(p, p + (last - first), pred, pool) - p);
+}
+
+template <pred::int_iterator It>
+It find(It first, It last, int value, ThreadPool& pool = ThreadPool::shared())
+{
+    const int* p = std::to_address(first);
+    return first + (par::find(p, p + (last - first), value, pool) - p);
+}
+
+template <pred::int_iterator It, typename Pred>
+bool none_of(It first, It last, Pred pred, ThreadPool& pool = ThreadPool::shared())
+{
+    return par::find_if(first, last, pred, pool) == last;
+}
+
+template <pred::int_iterator It, typename Pred>
+bool any_of(It first, It last, Pred pred, ThreadPool& pool = ThreadPool::shared())
+{
+    return !par::none_of(first, last, pred, pool);
+}
+
+template <pred::int_iterator It, typename Pred>
+bool all_of(It first, It last, Pred pred, ThreadPool& pool = ThreadPool::shared())
+{
+    return par::none_of(first, last, [pred](int v) { return !pred(v); }, pool);
+}
+
+} // namespace par
+
+#endif //SAM206_PARALLEL_H
@@ -0,0 +1,148 @@
+// perf_counters - count cycles, instructions, cache and branch misses per stage
+
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef __linux__
+
+namespace {
+const uint64_t events[COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+// glibc has no wrapper for this system call
+int open_counter(uint64_t event, int group)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = event;
+    attr.disabled = group < 0;          // the group starts when its leader is enabled
+    attr.exclude_kernel = 1;            // count only our own code - needs no special permission
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return int(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+}
+}
+
+PerfCounters::PerfCounters() : start(chrono::steady_clock::now())
+{
+    for (int c = 0; c < COUNTERS; c++) {
+        int fd = open_counter(events[c], group_fd);
+        if (fd < 0) {
+            if (why.empty())
+                why = string("perf_event_open: ") + strerror(errno);
+            continue;       // carry on without this one - the CPU may lack it
+        }
+        if (group_fd < 0)
+            group_fd = fd;
+        fds[c] = fd;
+        slot[c] = opened++;
+    }
+    if (group_fd >= 0) {
+        why.clear();
+        ioctl(group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (int fd : fds)
+        if (fd >= 0)
+            close(fd);
+}
+
+CounterReading PerfCounters::read() const
+{
+    CounterReading r;
+    if (group_fd >= 0) {
+        // layout of PERF_FORMAT_GROUP: count, time enabled, time running, values...
+        uint64_t data[3 + COUNTERS] = {};
+        if (::read(group_fd, data, sizeof data) > 0 && data[2] > 0) {
+            // when there are more counters than the CPU has, the kernel takes
+            // turns between them; scale up to the whole time the group was enabled
+            double scale = double(data[1]) / double(data[2]);
+            for (int c = 0; c < COUNTERS; c++)
+                if (slot[c] >= 0)
+                    r.counts[c] = uint64_t(double(data[3 + slot[c]]) * scale);
+        }
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    r.seconds = elapsed.count();
+    return r;
+}
+
+#else   // no perf_event_open - wall-clock time only
+
+PerfCounters::PerfCounters() : why("hardware counters are only supported on Linux"),
+                               start(chrono::steady_clock::now()) {}
+
+PerfCounters::~PerfCounters() = default;
+
+CounterReading PerfCounters::read() const
+{
+    CounterReading r;
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    r.seconds = elapsed.count();
+    return r;
+}
+
+#endif
+
+void StageReport::add(string name, const CounterReading& begin, const CounterReading& end)
+{
+    Stage s{move(name), {}};
+    s.delta.seconds = end.seconds - begin.seconds;
+    for (int c = 0; c < COUNTERS; c++)
+        s.delta.counts[c] = end.counts[c] >= begin.counts[c] ? end.counts[c] - begin.counts[c] : 0;
+    recorded.push_back(move(s));
+}
+
+void StageReport::print(ostream& os) const
+{
+    auto count = [&](const Stage& s, Counter c) {
+        if (perf.available(c))
+            os << setw(14) << s.delta.counts[int(c)];
+        else
+            os << setw(14) << "-";
+    };
+
+    ios::fmtflags flags = os.flags();
+    os << left << setw(24) << "stage" << right << setw(12) << "time (us)" << setw(14) << "cycles"
+       << setw(14) << "instructions" << setw(7) << "IPC" << setw(14) << "cache misses"
+       << setw(14) << "branch misses" << '\n';
+    for (const Stage& s : recorded) {
+        os << left << setw(24) << s.name << right << fixed << setprecision(1)
+           << setw(12) << s.delta.seconds * 1e6;
+        count(s, Counter::Cycles);
+        count(s, Counter::Instructions);
+        uint64_t cycles = s.delta.counts[int(Counter::Cycles)];
+        if (perf.available(Counter::Cycles) && perf.available(Counter::Instructions) && cycles > 0)
+            os << setw(7) << setprecision(2) << double(s.delta.counts[int(Counter::Instructions)]) / double(cycles);
+        else
+            os << setw(7) << "-";
+        count(s, Counter::CacheMisses);
+        count(s, Counter::BranchMisses);
+        os << '\n';
+    }
+    if (!perf.available())
+        os << "(hardware counters unavailable - " << perf.error() << "; wall-clock time only)\n";
+    os.flags(flags);
+}
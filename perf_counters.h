@@ -0,0 +1,130 @@
+// perf_counters - count cycles, instructions, cache and branch misses per stage
+//
+// https://man7.org/linux/man-pages/man2/perf_event_open.2.html
+
+#ifndef SAM206_PERF_COUNTERS_H
+#define SAM206_PERF_COUNTERS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ *  Hardware performance counters
+ *  The CPU itself can count what happens while a piece of code runs.  The
+ *  numbers tell us *why* a loop is slow, not just how slow it is:
+ *      cycles          clock ticks used
+ *      instructions    instructions completed - instructions / cycles (IPC)
+ *                      near 3-4 means the CPU is busy, below 1 means waiting
+ *      cache misses    data that had to come from main memory - a loop that
+ *                      moves a lot of memory (erase() in a loop) has many
+ *      branch misses   "if" tests the CPU guessed wrongly - a loop that tests
+ *                      random data (i % 2 == 0) can have many
+ *
+ *  On Linux the counters are read with perf_event_open().  They are not
+ *  always allowed (containers, virtual machines, perf_event_paranoid > 2);
+ *  then only the wall-clock time is measured and the counters show "-".
+ */
+enum class Counter { Cycles, Instructions, CacheMisses, BranchMisses };
+constexpr int COUNTERS = 4;
+
+// Totals since the PerfCounters were opened
+struct CounterReading {
+    double seconds = 0;
+    std::array<std::uint64_t, COUNTERS> counts{};
+};
+
+class PerfCounters {
+public:
+    PerfCounters();         // opens and starts the counters - never throws
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return group_fd >= 0; }
+    bool available(Counter c) const { return slot[int(c)] >= 0; }
+    // Why the counters could not be opened ("" when they could)
+    const std::string& error() const { return why; }
+
+    CounterReading read() const;
+
+private:
+    int group_fd = -1;                      // the first counter opened leads the group
+    std::array<int, COUNTERS> fds{-1, -1, -1, -1};
+    std::array<int, COUNTERS> slot{-1, -1, -1, -1};     // position in the group's read() data
+    int opened = 0;
+    std::string why;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ *  StageReport
+ *  Collects the counts for each named stage of a program, and prints them
+ *  as a table.  Stages are recorded with ScopedStage:
+ *
+ *      StageReport report;
+ *      {
+ *          ScopedStage stage(report, "populate");
+ *          populate_vector(ages_vector);
+ *          stage.next("erase even");       // ends "populate", starts "erase even"
+ *          ...
+ *      }                                   // ends "erase even" (or call stage.finish())
+ *      report.print(cerr);
+ */
+class StageReport {
+public:
+    struct Stage {
+        std::string name;
+        CounterReading delta;
+    };
+
+    void add(std::string name, const CounterReading& begin, const CounterReading& end);
+    const std::vector<Stage>& stages() const { return recorded; }
+    const PerfCounters& counters() const { return perf; }
+
+    void print(std::ostream& os) const;
+
+private:
+    PerfCounters perf;
+    std::vector<Stage> recorded;
+};
+
+class ScopedStage {
+public:
+    ScopedStage(StageReport& report, std::string name)
+        : report(report), name(std::move(name)), begin(report.counters().read()) {}
+    ~ScopedStage() { finish(); }
+
+    ScopedStage(const ScopedStage&) = delete;
+    ScopedStage& operator=(const ScopedStage&) = delete;
+
+    // End the current stage and start the next one
+    void next(std::string next_name)
+    {
+        finish();
+        name = std::move(next_name);
+        begin = report.counters().read();     // read again, so add() is not counted
+        running = true;
+    }
+
+    // End the current stage now, rather than at the end of the scope
+    void finish()
+    {
+        if (running)
+            report.add(std::move(name), begin, report.counters().read());
+        running = false;
+    }
+
+private:
+    StageReport& report;
+    std::string name;
+    CounterReading begin;
+    bool running = true;
+};
+
+#endif //SAM206_PERF_COUNTERS_H
@@ -0,0 +1,305 @@
+// predicate - a tiny compiled predicate language for vectors of int
+//
+// https://en.cppreference.com/w/cpp/language/operators
+
+#ifndef SAM206_PREDICATE_H
+#define SAM206_PREDICATE_H
+
+#include <climits>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+/**
+ *  Predicates
+ *  main.cpp passes lambdas such as [](int i){ return i < 18; } to the
+ *  <algorithm> functions.  Here the same predicates are written as small
+ *  expressions built from the placeholder "x":
+ *
+ *      pred::x < 18                    same as  [](int i){ return i < 18; }
+ *      pred::x > 16 && pred::x < 30    both must hold
+ *      pred::between(17, 21)           17 <= i <= 21
+ *      pred::mod<2> == 0               same as  [](int i){ return i%2 == 0; }
+ *      !(pred::x == 21)                negation
+ *
+ *  Each expression is a different type, so the compiler sees the whole
+ *  predicate at compile time and inlines it.  && || and ! evaluate BOTH
+ *  sides without branching, which lets the kernels below (count_if,
+ *  all_of, none_of, find_if) be turned into SIMD code by the optimiser.
+ *  Every expression is also an ordinary unary predicate - it can be
+ *  passed to the std:: algorithms and gives identical answers.
+ */
+namespace pred {
+
+// Base class for every expression node (CRTP).  It lets the operators below
+// accept only predicate expressions and not arbitrary types.
+template <typename Derived>
+struct Expr {
+    const Derived& self() const { return static_cast<const Derived&>(*this); }
+};
+
+// The placeholder that stands for the element being tested.
+struct Var {};
+inline constexpr Var x{};
+
+// The placeholder for "element % M" - M is fixed at compile time so that
+// the remainder is computed with shifts and multiplies, not a division.
+template <int M>
+struct ModVar {
+    static_assert(M > 0, "modulus must be positive");
+};
+template <int M>
+inline constexpr ModVar<M> mod{};
+
+#define SAM206_PRED_COMPARE(Name, op)                                    \
+    struct Name : Expr<Name> {                                           \
+        int c;                                                           \
+        constexpr explicit Name(int c) : c(c) {}                         \
+        constexpr bool operator()(int v) const { return v op c; }        \
+    };                                                                   \
+    constexpr Name operator op(Var, int c) { return Name(c); }
+
+SAM206_PRED_COMPARE(Less, <)
+SAM206_PRED_COMPARE(LessEqual, <=)
+SAM206_PRED_COMPARE(Greater, >)
+SAM206_PRED_COMPARE(GreaterEqual, >=)
+SAM206_PRED_COMPARE(Equal, ==)
+SAM206_PRED_COMPARE(NotEqual, !=)
+
+#undef SAM206_PRED_COMPARE
+
+// lo <= v <= hi, using a single unsigned comparison
+struct Between : Expr<Between> {
+    int lo, hi;
+    constexpr Between(int lo, int hi) : lo(lo), hi(hi) {}
+    constexpr bool operator()(int v) const
+    {
+        return unsigned(v) - unsigned(lo) <= unsigned(hi) - unsigned(lo);
+    }
+};
+constexpr Between between(int lo, int hi) { return Between(lo, hi); }
+
+// v % M == r  (C++ semantics, so negative v gives a negative remainder)
+template <int M>
+struct ModEqual : Expr<ModEqual<M>> {
+    int r;
+    constexpr explicit ModEqual(int r) : r(r) {}
+    constexpr bool operator()(int v) const { return v % M == r; }
+};
+template <int M>
+constexpr ModEqual<M> operator==(ModVar<M>, int r) { return ModEqual<M>(r); }
+
+template <typename A, typename B>
+struct And : Expr<And<A, B>> {
+    A a;
+    B b;
+    constexpr And(A a, B b) : a(a), b(b) {}
+    constexpr bool operator()(int v) const { return a(v) & b(v); }
+};
+
+template <typename A, typename B>
+struct Or : Expr<Or<A, B>> {
+    A a;
+    B b;
+    constexpr Or(A a, B b) : a(a), b(b) {}
+    constexpr bool operator()(int v) const { return a(v) | b(v); }
+};
+
+template <typename A>
+struct Not : Expr<Not<A>> {
+    A a;
+    constexpr explicit Not(A a) : a(a) {}
+    constexpr bool operator()(int v) const { return !a(v); }
+};
+
+template <typename A, typename B>
+constexpr And<A, B> operator&&(const Expr<A>& a, const Expr<B>& b) { return {a.self(), b.self()}; }
+
+template <typename A, typename B>
+constexpr Or<A, B> operator||(const Expr<A>& a, const Expr<B>& b) { return {a.self(), b.self()}; }
+
+template <typename A>
+constexpr Not<A> operator!(const Expr<A>& a) { return Not<A>(a.self()); }
+
+/**
+ *  Kernels
+ *  The data is processed in blocks.  Inside a block there are no branches
+ *  (the loop only adds or ORs predicate results), so it vectorises.  The
+ *  short-circuiting kernels check once per block whether they can stop.
+ */
+constexpr std::ptrdiff_t BLOCK = 256;
+
+template <typename P>
+std::ptrdiff_t count_if(const int* first, const int* last, const Expr<P>& e)
+{
+    const P& p = e.self();
+    std::ptrdiff_t n = 0;
+    while (last - first >= BLOCK) {
+        unsigned block = 0;
+        for (std::ptrdiff_t i = 0; i < BLOCK; i++)
+            block += p(first[i]);
+        n += block;
+        first += BLOCK;
+    }
+    for (; first != last; ++first)
+        n += p(*first);
+    return n;
+}
+
+template <typename P>
+const int* find_if(const int* first, const int* last, const Expr<P>& e)
+{
+    const P& p = e.self();
+    while (last - first >= BLOCK) {
+        bool any = false;
+        for (std::ptrdiff_t i = 0; i < BLOCK; i++)
+            any |= p(first[i]);
+        if (any)
+            break;      // the match is in this block - locate it below
+        first += BLOCK;
+    }
+    for (; first != last; ++first)
+        if (p(*first))
+            return first;
+    return last;
+}
+
+template <typename P>
+bool none_of(const int* first, const int* last, const Expr<P>& e)
+{
+    return pred::find_if(first, last, e) == last;
+}
+
+template <typename P>
+bool any_of(const int* first, const int* last, const Expr<P>& e)
+{
+    return !pred::none_of(first, last, e);
+}
+
+template <typename P>
+bool all_of(const int* first, const int* last, const Expr<P>& e)
+{
+    return pred::none_of(first, last, !e);
+}
+
+// Iterator versions, so that calls look like the <algorithm> ones:
+//      pred::count_if(ages_vector.begin(), ages_vector.end(), pred::x < 18)
+template <typename It>
+concept int_iterator = std::contiguous_iterator<It> &&
+                       std::is_same_v<std::iter_value_t<It>, int>;
+
+template <int_iterator It, typename P>
+std::ptrdiff_t count_if(It first, It last, const Expr<P>& e)
+{
+    const int* p = std::to_address(first);     // int* becomes const int* here
+    return pred::count_if(p, p + (last - first), e);
+}
+
+template <int_iterator It, typename P>
+It find_if(It first, It last, const Expr<P>& e)
+{
+    const int* p = std::to_address(first);
+    return first + (pred::find_if(p, p + (last - first), e) - p);
+}
+
+template <int_iterator It, typename P>
+bool none_of(It first, It last, const Expr<P>& e)
+{
+    return pred::find_if(first, last, e) == last;
+}
+
+template <int_iterator It, typename P>
+bool any_of(It first, It last, const Expr<P>& e)
+{
+    return !pred::none_of(first, last, e);
+}
+
+template <int_iterator It, typename P>
+bool all_of(It first, It last, const Expr<P>& e)
+{
+    return pred::none_of(first, last, !e);
+}
+
+/**
+ *  Ranges
+ *  Many predicates accept exactly the values in one interval, or exactly
+ *  the values outside one:
+ *
+ *      x < 18                  [INT_MIN, 17]
+ *      x > 16 && x < 30        [17, 29]
+ *      !(x == 21)              outside [21, 21]
+ *
+ *  range_of() works out that interval.  A container that stores ages in
+ *  compressed form (see packed_ages.h) can then compare its codes with
+ *  the two ends instead of decoding every age and calling the predicate.
+ *  range_of() returns nullopt when && or || of two ranges is not a range,
+ *  and has_range<P> is false for predicates such as mod<2> == 0 that are
+ *  never a single interval.
+ */
+struct Range {
+    int lo, hi;         // lo > hi means the interval is empty
+    bool outside;       // true: accept the values NOT in [lo, hi]
+
+    constexpr bool contains(int v) const { return (lo <= v && v <= hi) != outside; }
+};
+
+constexpr std::optional<Range> range_of(const Less& p)
+{
+    return p.c == INT_MIN ? Range{1, 0, false} : Range{INT_MIN, p.c - 1, false};
+}
+constexpr std::optional<Range> range_of(const LessEqual& p) { return Range{INT_MIN, p.c, false}; }
+constexpr std::optional<Range> range_of(const Greater& p)
+{
+    return p.c == INT_MAX ? Range{1, 0, false} : Range{p.c + 1, INT_MAX, false};
+}
+constexpr std::optional<Range> range_of(const GreaterEqual& p) { return Range{p.c, INT_MAX, false}; }
+constexpr std::optional<Range> range_of(const Equal& p) { return Range{p.c, p.c, false}; }
+constexpr std::optional<Range> range_of(const NotEqual& p) { return Range{p.c, p.c, true}; }
+
+// Between wraps around like the unsigned comparison it uses: with lo > hi
+// it accepts everything except hi+1 .. lo-1
+constexpr std::optional<Range> range_of(const Between& p)
+{
+    if (p.lo <= p.hi)
+        return Range{p.lo, p.hi, false};
+    return Range{p.hi + 1, p.lo - 1, true};
+}
+
+template <typename P>
+concept has_range = requires(const P& p) { { range_of(p) } -> std::same_as<std::optional<Range>>; };
+
+template <has_range A>
+constexpr std::optional<Range> range_of(const Not<A>& p)
+{
+    std::optional<Range> r = range_of(p.a);
+    if (r)
+        r->outside = !r->outside;
+    return r;
+}
+
+// inside one interval and inside another: inside both
+template <has_range A, has_range B>
+constexpr std::optional<Range> range_of(const And<A, B>& p)
+{
+    std::optional<Range> a = range_of(p.a), b = range_of(p.b);
+    if (!a || !b || a->outside || b->outside)
+        return std::nullopt;
+    return Range{a->lo > b->lo ? a->lo : b->lo, a->hi < b->hi ? a->hi : b->hi, false};
+}
+
+// outside one interval or outside another: outside the part they share
+template <has_range A, has_range B>
+constexpr std::optional<Range> range_of(const Or<A, B>& p)
+{
+    std::optional<Range> a = range_of(p.a), b = range_of(p.b);
+    if (!a || !b || !a->outside || !b->outside)
+        return std::nullopt;
+    return Range{a->lo > b->lo ? a->lo : b->lo, a->hi < b->hi ? a->hi : b->hi, true};
+}
+
+} // namespace pred
+
+#endif //SAM206_PREDICATE_H
@@ -0,0 +1,147 @@
+// query_batch - answer several vector queries in a single pass
+//
+// https://en.cppreference.com/w/cpp/language/fold
+
+#ifndef SAM206_QUERY_BATCH_H
+#define SAM206_QUERY_BATCH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <vector>
+#include "predicate.h"
+
+/**
+ *  Fused queries
+ *  main() calls count(), count_if(), all_of(), none_of(), find() and
+ *  find_if() one after another, and each call reads the whole vector from
+ *  memory again.  query::scan() takes a list of queries and answers all of
+ *  them while reading the vector only once:
+ *
+ *      auto [n21, under18, all_over16, first_even] =
+ *          query::scan(ages_vector,
+ *                      query::count(21),
+ *                      query::count_if(pred::x < 18),
+ *                      query::all_of(pred::x > 16),
+ *                      query::find_if(pred::mod<2> == 0));
+ *
+ *  The vector is read in blocks small enough to stay in the L1 cache, and
+ *  every query looks at a block before the scan moves on to the next one.
+ *  all_of/none_of/any_of/find/find_if are "settled" as soon as their answer
+ *  is known and then skip the remaining blocks.  The scan stops early only
+ *  when every query is settled - a count has to see every element.
+ *
+ *  find() and find_if() give the INDEX of the first match, or
+ *  query::not_found (-1) if there is no match.
+ */
+namespace query {
+
+constexpr std::ptrdiff_t not_found = -1;
+
+// 4096 ints = 16 KB, about a third of a typical L1 data cache
+constexpr std::ptrdiff_t BLOCK = 4096;
+
+template <typename P>
+struct CountIf {
+    using result_type = std::ptrdiff_t;
+    static constexpr bool short_circuit = false;
+
+    P p;
+    std::ptrdiff_t n = 0;
+
+    bool settled() const { return false; }
+    void scan(const int* block, std::ptrdiff_t size, std::ptrdiff_t)
+    {
+        n += pred::count_if(block, block + size, p);
+    }
+    result_type result() const { return n; }
+};
+
+template <typename P>
+struct FindIf {
+    using result_type = std::ptrdiff_t;
+    static constexpr bool short_circuit = true;
+
+    P p;
+    std::ptrdiff_t index = not_found;
+
+    bool settled() const { return index != not_found; }
+    void scan(const int* block, std::ptrdiff_t size, std::ptrdiff_t offset)
+    {
+        const int* hit = pred::find_if(block, block + size, p);
+        if (hit != block + size)
+            index = offset + (hit - block);
+    }
+    result_type result() const { return index; }
+};
+
+// any_of(p) is settled by the first match, so it is a find_if() that only
+// reports whether something was found.  none_of(p) and all_of(p) are
+// expressed through it: none_of(p) == !any_of(p), all_of(p) == !any_of(!p).
+template <typename P, bool Negate>
+struct AnyOf {
+    using result_type = bool;
+    static constexpr bool short_circuit = true;
+
+    FindIf<P> find;
+
+    bool settled() const { return find.settled(); }
+    void scan(const int* block, std::ptrdiff_t size, std::ptrdiff_t offset)
+    {
+        find.scan(block, size, offset);
+    }
+    result_type result() const { return find.settled() != Negate; }
+};
+
+template <typename P>
+CountIf<P> count_if(const pred::Expr<P>& e) { return {e.self()}; }
+
+inline CountIf<pred::Equal> count(int value) { return {pred::x == value}; }
+
+template <typename P>
+FindIf<P> find_if(const pred::Expr<P>& e) { return {e.self()}; }
+
+inline FindIf<pred::Equal> find(int value) { return {pred::x == value}; }
+
+template <typename P>
+AnyOf<P, false> any_of(const pred::Expr<P>& e) { return {{e.self()}}; }
+
+template <typename P>
+AnyOf<P, true> none_of(const pred::Expr<P>& e) { return {{e.self()}}; }
+
+template <typename P>
+AnyOf<pred::Not<P>, true> all_of(const pred::Expr<P>& e) { return {{!e}}; }
+
+/**
+ * Run all of the queries over [first, last) in one pass.
+ * @return a tuple with one result per query, in the order they were given
+ */
+template <typename... Q>
+std::tuple<typename Q::result_type...> scan(const int* first, const int* last, Q... queries)
+{
+    constexpr bool can_stop_early = (Q::short_circuit && ...);
+
+    for (std::ptrdiff_t offset = 0; offset < last - first; offset += BLOCK) {
+        const int* block = first + offset;
+        std::ptrdiff_t size = std::min(BLOCK, last - block);
+
+        // give the block to every query that still needs to see data
+        ((queries.settled() ? void() : queries.scan(block, size, offset)), ...);
+
+        if constexpr (can_stop_early) {
+            if ((queries.settled() && ...))
+                break;
+        }
+    }
+    return {queries.result()...};
+}
+
+template <typename... Q>
+std::tuple<typename Q::result_type...> scan(const std::vector<int>& vect, Q... queries)
+{
+    return scan(vect.data(), vect.data() + vect.size(), queries...);
+}
+
+} // namespace query
+
+#endif //SAM206_QUERY_BATCH_H
@@ -0,0 +1,286 @@
+// small_vector - a vector that keeps its first N elements inside the object
+//
+// https://en.cppreference.com/w/cpp/container/vector
+
+#ifndef SAM206_SMALL_VECTOR_H
+#define SAM206_SMALL_VECTOR_H
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+/**
+ *  SmallVector
+ *  vector<int> lottoDraw { 02,10,13,22,35,47 } asks the heap for memory to
+ *  hold six ints - and gives it back when lottoDraw goes away.  For a
+ *  collection that is nearly always small, that costs far more than using
+ *  the numbers.  SmallVector<T, N> has room for N elements inside the
+ *  object itself (on the stack, for a local variable); only when it grows
+ *  past N does it move its elements to the heap, like a vector.
+ *
+ *      SmallVector<int, 6> lottoDraw { 02,10,13,22,35,47 };   // no heap memory
+ *
+ *  It has the vector interface main.cpp uses - begin/end/cbegin/cend,
+ *  push_back, pop_back, erase, insert, clear, size, empty, [], at - and the
+ *  comparison operators == != < <= > >=.  Its iterators are plain
+ *  pointers, so all of <algorithm> (and count_equal, pred::...) works.
+ *
+ *  As with vector, anything that changes the size may invalidate iterators.
+ *  Moving a SmallVector that still uses its inline storage moves each
+ *  element (the storage cannot be handed over), so moves cost O(N).
+ */
+template <typename T, std::size_t N>
+class SmallVector {
+    static_assert(N > 0, "use std::vector when there is no inline storage");
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    SmallVector() = default;
+    SmallVector(size_type count, const T& value) { assign(count, value); }
+    SmallVector(std::initializer_list<T> values) { assign(values.begin(), values.end()); }
+    template <std::input_iterator It>
+    SmallVector(It first, It last) { assign(first, last); }
+
+    SmallVector(const SmallVector& other) { assign(other.begin(), other.end()); }
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) { take(std::move(other)); }
+
+    SmallVector& operator=(const SmallVector& other)
+    {
+        if (this != &other)
+            assign(other.begin(), other.end());
+        return *this;
+    }
+    SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        if (this != &other) {
+            clear();
+            free_heap();
+            take(std::move(other));
+        }
+        return *this;
+    }
+    SmallVector& operator=(std::initializer_list<T> values)
+    {
+        assign(values.begin(), values.end());
+        return *this;
+    }
+
+    ~SmallVector()
+    {
+        clear();
+        free_heap();
+    }
+
+    template <std::input_iterator It>
+    void assign(It first, It last)
+    {
+        clear();
+        for (; first != last; ++first)
+            emplace_back(*first);
+    }
+    void assign(size_type count, const T& value)
+    {
+        clear();
+        reserve(count);
+        for (size_type i = 0; i < count; i++)
+            emplace_back(value);
+    }
+
+    size_type size() const { return used; }
+    size_type capacity() const { return cap; }
+    bool empty() const { return used == 0; }
+    // true while the elements are still stored inside the object
+    bool is_inline() const { return ptr == inline_data(); }
+    static constexpr size_type inline_capacity() { return N; }
+
+    T* data() { return ptr; }
+    const T* data() const { return ptr; }
+
+    iterator begin() { return ptr; }
+    iterator end() { return ptr + used; }
+    const_iterator begin() const { return ptr; }
+    const_iterator end() const { return ptr + used; }
+    const_iterator cbegin() const { return ptr; }
+    const_iterator cend() const { return ptr + used; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator crend() const { return rend(); }
+
+    T& operator[](size_type i) { return ptr[i]; }
+    const T& operator[](size_type i) const { return ptr[i]; }
+    T& at(size_type i) { check(i); return ptr[i]; }
+    const T& at(size_type i) const { check(i); return ptr[i]; }
+    T& front() { return ptr[0]; }
+    const T& front() const { return ptr[0]; }
+    T& back() { return ptr[used - 1]; }
+    const T& back() const { return ptr[used - 1]; }
+
+    void reserve(size_type n)
+    {
+        if (n > cap)
+            grow_to(n);
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (used == cap) {
+            // build the new element first: args may refer to an element of this vector
+            T value(std::forward<Args>(args)...);
+            grow_to(cap * 2);
+            return *::new (static_cast<void*>(ptr + used++)) T(std::move(value));
+        }
+        return *::new (static_cast<void*>(ptr + used++)) T(std::forward<Args>(args)...);
+    }
+
+    void pop_back() { std::destroy_at(ptr + --used); }
+
+    void clear()
+    {
+        std::destroy(ptr, ptr + used);
+        used = 0;
+    }
+
+    void resize(size_type n, const T& value = T())
+    {
+        if (n < used) {
+            std::destroy(ptr + n, ptr + used);
+            used = n;
+        } else {
+            reserve(n);
+            while (used < n)
+                emplace_back(value);
+        }
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        T* f = ptr + (first - ptr);
+        T* l = ptr + (last - ptr);
+        if (f != l) {
+            T* new_end = std::move(l, end(), f);
+            std::destroy(new_end, end());
+            used = size_type(new_end - ptr);
+        }
+        return f;
+    }
+
+    iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+    iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        size_type index = size_type(pos - ptr);
+        emplace_back(std::forward<Args>(args)...);
+        std::rotate(ptr + index, ptr + used - 1, ptr + used);
+        return ptr + index;
+    }
+
+    void swap(SmallVector& other)
+    {
+        SmallVector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    friend bool operator==(const SmallVector& a, const SmallVector& b)
+    {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end());
+    }
+    friend auto operator<=>(const SmallVector& a, const SmallVector& b)
+    {
+        return std::lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+private:
+    T* inline_data() { return reinterpret_cast<T*>(storage); }
+    const T* inline_data() const { return reinterpret_cast<const T*>(storage); }
+
+    void check(size_type i) const
+    {
+        if (i >= used)
+            throw std::out_of_range("SmallVector::at: index " + std::to_string(i)
+                                    + " >= size " + std::to_string(used));
+    }
+
+    // Move the elements into a heap block of n elements.  As with vector,
+    // elements whose move might throw are copied instead, so if that throws
+    // the new block is freed and *this is left as it was.
+    void grow_to(size_type n)
+    {
+        T* block = static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        try {
+            if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+                std::uninitialized_move(ptr, ptr + used, block);
+            else
+                std::uninitialized_copy(ptr, ptr + used, block);
+        } catch (...) {
+            ::operator delete(block, std::align_val_t(alignof(T)));
+            throw;
+        }
+        std::destroy(ptr, ptr + used);
+        free_heap();
+        ptr = block;
+        cap = n;
+    }
+
+    void free_heap()
+    {
+        if (!is_inline())
+            ::operator delete(ptr, std::align_val_t(alignof(T)));
+        ptr = inline_data();
+        cap = N;
+    }
+
+    // take other's elements, leaving it empty; *this must be empty and inline
+    void take(SmallVector&& other)
+    {
+        if (other.is_inline()) {
+            std::uninitialized_move(other.begin(), other.end(), inline_data());
+            used = other.used;
+            other.clear();
+        } else {
+            ptr = other.ptr;
+            cap = other.cap;
+            used = other.used;
+            other.ptr = other.inline_data();
+            other.cap = N;
+            other.used = 0;
+        }
+    }
+
+    alignas(T) unsigned char storage[N * sizeof(T)];
+    T* ptr = inline_data();
+    size_type used = 0;
+    size_type cap = N;
+};
+
+#endif //SAM206_SMALL_VECTOR_H
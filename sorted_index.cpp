@@ -0,0 +1,106 @@
+// sorted_index - answer membership and range questions in O(log n)
+
+#include "sorted_index.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// Place sorted[i], i = next, next+1, ... at the nodes of the subtree rooted
+// at k, in order: left subtree, node k, right subtree.
+void fill_in_order(const vector<int>& sorted, size_t& next, size_t k, vector<int>& tree)
+{
+    if (k >= tree.size())
+        return;
+    fill_in_order(sorted, next, 2 * k, tree);
+    tree[k] = sorted[next++];
+    fill_in_order(sorted, next, 2 * k + 1, tree);
+}
+
+} // namespace
+
+void SortedIndex::build(const int* first, const int* last)
+{
+    vector<int> sorted(first, last);
+    sort(sorted.begin(), sorted.end());
+
+    n = sorted.size();
+    depth = n == 0 ? 0 : 63 - __builtin_clzll(n);
+    last_level = n == 0 ? 0 : n - (size_t(1) << depth) + 1;
+    tree.assign(n + 1, 0);
+    size_t next = 0;
+    fill_in_order(sorted, next, 1, tree);
+}
+
+/*
+ * If the last level were full, reading the tree in order would give the
+ * last-level nodes at the even positions 0, 2, 4 ..., and node k - the
+ * j-th node at depth d - at position r = (2j + 1) * 2^(depth - d) - 1.
+ * Only the first last_level nodes of the last level exist.  ceil(r / 2)
+ * last-level positions come before r; the missing ones are subtracted.
+ */
+size_t SortedIndex::rank_of(size_t k) const
+{
+    int d = 63 - __builtin_clzll(k);
+    size_t j = k - (size_t(1) << d);
+    size_t r = ((2 * j + 1) << (depth - d)) - 1;
+    size_t before = (r + 1) / 2;
+    return before > last_level ? r - (before - last_level) : r;
+}
+
+// The same, backwards: from position i to r, then r + 1 = (2j + 1) * 2^(depth - d)
+size_t SortedIndex::node_at(size_t i) const
+{
+    size_t r = i < 2 * last_level ? i : 2 * i - 2 * last_level + 1;
+    int up = __builtin_ctzll(r + 1);
+    return (size_t(1) << (depth - up)) + ((r + 1) >> (up + 1));
+}
+
+/*
+ * Walk down from the root, going right while the node is too small.  The
+ * path taken is written in the bits of k: after the last step, the final
+ * "went left" turn marks the answer, so shifting away the trailing 1 bits
+ * (the right turns after it) plus that one 0 bit gives its node.
+ * If the walk only ever went right, every node is too small and k becomes 0.
+ */
+size_t SortedIndex::search_lower(int x) const
+{
+    const int* t = tree.data();
+    size_t k = 1;
+    while (k <= n) {
+        __builtin_prefetch(t + min(16 * k, n));    // the node four levels down
+        k = 2 * k + (t[k] < x);
+    }
+    return k >> __builtin_ffsll(static_cast<long long>(~k));
+}
+
+size_t SortedIndex::search_upper(int x) const
+{
+    const int* t = tree.data();
+    size_t k = 1;
+    while (k <= n) {
+        __builtin_prefetch(t + min(16 * k, n));
+        k = 2 * k + (t[k] <= x);
+    }
+    return k >> __builtin_ffsll(static_cast<long long>(~k));
+}
+
+size_t SortedIndex::lower_bound(int x) const
+{
+    size_t k = search_lower(x);
+    return k == 0 ? n : rank_of(k);
+}
+
+size_t SortedIndex::upper_bound(int x) const
+{
+    size_t k = search_upper(x);
+    return k == 0 ? n : rank_of(k);
+}
+
+bool SortedIndex::contains(int x) const
+{
+    size_t k = search_lower(x);
+    return k != 0 && tree[k] == x;
+}
@@ -0,0 +1,150 @@
+// sorted_index - answer membership and range questions in O(log n)
+//
+// https://algorithmica.org/en/eytzinger
+
+#ifndef SAM206_SORTED_INDEX_H
+#define SAM206_SORTED_INDEX_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+/**
+ *  SortedIndex
+ *  find(begin, end, 17) and count_if(... i < 18) look at every element.
+ *  If the ages are kept sorted as well, binary search answers the same
+ *  questions in O(log n) steps.  An ordinary binary search jumps around
+ *  a big array and nearly every step is a cache miss, so the sorted ages
+ *  are stored in "Eytzinger" order instead - the order of a binary tree
+ *  read level by level, like a heap:
+ *
+ *      sorted      1 2 3 4 5 6 7
+ *      eytzinger   4 2 6 1 3 5 7      children of node k are 2k and 2k+1
+ *
+ *  The first levels of the search always read the same few elements, so
+ *  they stay in the cache, and the 16 nodes four levels further down are
+ *  next to each other and can be prefetched while the search goes on.
+ *  Each step is branch free: k = 2k + (node < x).  The position of node k
+ *  in sorted order follows from k and n alone (see rank_of), so the index
+ *  stores nothing but the ages themselves.
+ *
+ *      lower_bound(x)      number of ages < x  (the position std::lower_bound would give)
+ *      upper_bound(x)      number of ages <= x
+ *      contains(x)         find(...) != end
+ *      count(x)            count(..., x)
+ *      count_less(x)       count_if(... i < x)
+ *      count_between(lo, hi)   ages with lo <= age <= hi
+ *
+ *  The index is a snapshot: build() it again after the ages change, or
+ *  use IndexedVector below, which does that by itself.
+ */
+class SortedIndex {
+public:
+    SortedIndex() = default;
+    SortedIndex(const int* first, const int* last) { build(first, last); }
+    explicit SortedIndex(const std::vector<int>& values) { build(values); }
+
+    void build(const int* first, const int* last);
+    void build(const std::vector<int>& values) { build(values.data(), values.data() + values.size()); }
+
+    std::size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+
+    std::size_t lower_bound(int x) const;
+    std::size_t upper_bound(int x) const;
+
+    bool contains(int x) const;
+    std::size_t count(int x) const { return upper_bound(x) - lower_bound(x); }
+    std::size_t count_less(int x) const { return lower_bound(x); }
+    std::size_t count_between(int lo, int hi) const { return lo > hi ? 0 : upper_bound(hi) - lower_bound(lo); }
+
+    // i-th smallest value, 0 <= i < size()
+    int nth(std::size_t i) const { return tree[node_at(i)]; }
+
+private:
+    // Eytzinger index of the first node >= x (or > x), or 0 when there is none
+    std::size_t search_lower(int x) const;
+    std::size_t search_upper(int x) const;
+
+    // position of node k in sorted order, and the node at position i
+    std::size_t rank_of(std::size_t k) const;
+    std::size_t node_at(std::size_t i) const;
+
+    std::size_t n = 0;
+    int depth = 0;                          // depth of the last level, the root is at depth 0
+    std::size_t last_level = 0;             // number of nodes on the last level
+    std::vector<int> tree;                  // tree[1..n] in Eytzinger order, tree[0] unused
+};
+
+/**
+ *  IndexedVector
+ *  A vector of int with a SortedIndex next to it.  Every change - push_back,
+ *  pop_back, erase, set, clear - only marks the index as out of date; the
+ *  next query rebuilds it (O(n log n)) and later queries reuse it until the
+ *  next change.  So an erase loop followed by many lookups sorts once:
+ *
+ *      IndexedVector ages_vector{17, 19, 16, 18, 20, 21};
+ *      for (auto it = ages_vector.begin(); it != ages_vector.end(); )
+ *          it = (*it % 2 == 0) ? ages_vector.erase(it) : it + 1;    // no sorting yet
+ *      ages_vector.contains(17);       // sorts once
+ *      ages_vector.count_less(18);     // uses the same index
+ *
+ *  Queries are const but may rebuild the index, so - as with any lazily
+ *  built cache - two threads must not query a changed IndexedVector at
+ *  the same time.
+ */
+class IndexedVector {
+public:
+    using value_type = int;
+    using size_type = std::size_t;
+    using const_iterator = std::vector<int>::const_iterator;
+    using iterator = const_iterator;
+
+    IndexedVector() = default;
+    IndexedVector(std::initializer_list<int> values) : values(values) {}
+    explicit IndexedVector(std::vector<int> values) : values(std::move(values)) {}
+
+    void push_back(int v) { values.push_back(v); stale = true; }
+    void pop_back() { values.pop_back(); stale = true; }
+    const_iterator erase(const_iterator pos) { stale = true; return values.erase(pos); }
+    const_iterator erase(const_iterator first, const_iterator last) { stale = true; return values.erase(first, last); }
+    void set(size_type i, int v) { values.at(i) = v; stale = true; }
+    void clear() { values.clear(); stale = true; }
+    void reserve(size_type n) { values.reserve(n); }
+
+    size_type size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+    int operator[](size_type i) const { return values[i]; }
+    int at(size_type i) const { return values.at(i); }
+    const std::vector<int>& vector() const { return values; }
+
+    const_iterator begin() const { return values.cbegin(); }
+    const_iterator end() const { return values.cend(); }
+    const_iterator cbegin() const { return values.cbegin(); }
+    const_iterator cend() const { return values.cend(); }
+
+    // the index, rebuilt first if the values changed since it was built
+    const SortedIndex& index() const
+    {
+        if (stale) {
+            sorted.build(values);
+            stale = false;
+        }
+        return sorted;
+    }
+
+    bool contains(int x) const { return index().contains(x); }
+    size_type count(int x) const { return index().count(x); }
+    size_type count_less(int x) const { return index().count_less(x); }
+    size_type count_between(int lo, int hi) const { return index().count_between(lo, hi); }
+    size_type lower_bound(int x) const { return index().lower_bound(x); }
+    size_type upper_bound(int x) const { return index().upper_bound(x); }
+
+private:
+    std::vector<int> values;
+    mutable SortedIndex sorted;
+    mutable bool stale = true;
+};
+
+#endif //SAM206_SORTED_INDEX_H
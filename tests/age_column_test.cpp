@@ -0,0 +1,112 @@
+// age_column_test - AgeColumn must behave like the vector<int> it replaces
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "../age_column.h"
+#include "check.h"
+using namespace std;
+
+bool same(const AgeColumn& column, const vector<int>& v)
+{
+    return column.size() == v.size() && equal(column.begin(), column.end(), v.begin(), v.end());
+}
+
+// every query of the column against the <algorithm> answer on the vector
+void check_queries(const AgeColumn& column, const vector<int>& v)
+{
+    CHECK(same(column, v));
+    for (int age : {0, 16, 17, 18, 21, 30, 255, -1, 256}) {
+        CHECK(column.count(age) == count(v.begin(), v.end(), age));
+        CHECK(column.find(age) - column.begin() == find(v.begin(), v.end(), age) - v.begin());
+        // the std:: algorithms must accept the column's iterators too
+        CHECK(count(column.cbegin(), column.cend(), age) == column.count(age));
+    }
+    auto under18 = [](int i) { return i < 18; };
+    auto over16 = [](int i) { return i > 16; };
+    auto is_even = [](int i) { return i % 2 == 0; };
+    CHECK(column.count_if(pred::x < 18) == count_if(v.begin(), v.end(), under18));
+    CHECK(column.all_of(pred::x > 16) == all_of(v.begin(), v.end(), over16));
+    CHECK(column.none_of(pred::x < 18) == none_of(v.begin(), v.end(), under18));
+    CHECK(column.find_if(pred::mod<2> == 0) - column.begin() == find_if(v.begin(), v.end(), is_even) - v.begin());
+}
+
+int main()
+{
+    mt19937 gen(206);
+    uniform_int_distribution<int> age(16, 30);
+
+    AgeColumn column;
+    vector<int> v;
+    check_queries(column, v);
+
+    // sizes around the 255 / 256 element blocks that count() and find_if() use
+    for (int n : {1, 254, 255, 256, 257, 1000}) {
+        column.clear();
+        v.clear();
+        for (int i = 0; i < n; i++) {
+            int a = age(gen);
+            column.push_back(a);
+            v.push_back(a);
+        }
+        check_queries(column, v);
+    }
+
+    // the checked path: ages that do not fit in a byte are rejected, not truncated
+    bool threw = false;
+    try {
+        column.push_back(256);
+    } catch (const out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+    threw = false;
+    try {
+        column.set(0, -1);
+    } catch (const out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(same(column, v));
+
+    // set, erase and pop_back, as main() uses them on the vector
+    column.set(10, 255);
+    v[10] = 255;
+    column.set(0, 0);
+    v[0] = 0;
+    check_queries(column, v);
+
+    auto erased = column.erase(column.begin() + 3);
+    auto v_erased = v.erase(v.begin() + 3);
+    CHECK(erased - column.begin() == v_erased - v.begin());
+    erased = column.erase(column.begin() + 100, column.begin() + 400);
+    v_erased = v.erase(v.begin() + 100, v.begin() + 400);
+    CHECK(erased - column.begin() == v_erased - v.begin());
+    column.pop_back();
+    v.pop_back();
+    check_queries(column, v);
+
+    // erase every even age, the way main.cpp does
+    for (auto it = column.begin(); it != column.end();)
+        it = (*it % 2 == 0) ? column.erase(it) : it + 1;
+    v.erase(remove_if(v.begin(), v.end(), [](int i) { return i % 2 == 0; }), v.end());
+    check_queries(column, v);
+
+    CHECK(column.at(0) == v.at(0));
+    threw = false;
+    try {
+        column.at(column.size());
+    } catch (const out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    AgeColumn smaller = {18, 17, 21};
+    AgeColumn larger = {18, 17, 22};
+    CHECK(smaller == AgeColumn({18, 17, 21}));
+    CHECK(smaller < larger);
+    CHECK(!(smaller == larger));
+
+    return check_report();
+}
@@ -0,0 +1,112 @@
+// age_histogram_test - an AgeColumn's histogram must stay equal to its ages
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "../age_column.h"
+#include "check.h"
+using namespace std;
+
+// the histogram answers must match the ages themselves
+void check_histogram(const AgeColumn& column, const vector<int>& v)
+{
+    const AgeHistogram& h = column.histogram();
+    CHECK(h.size() == v.size());
+    CHECK(h.empty() == v.empty());
+    for (int age = -1; age <= 256; age++) {
+        CHECK(h.count(age) == count(v.begin(), v.end(), age));
+        CHECK(h.count_less(age) == count_if(v.begin(), v.end(), [&](int i) { return i < age; }));
+    }
+    if (!v.empty()) {
+        CHECK(h.min() == *min_element(v.begin(), v.end()));
+        CHECK(h.max() == *max_element(v.begin(), v.end()));
+    }
+    for (int lo : {0, 16, 17, 63, 64, 100, 200, 255}) {
+        for (int hi : {0, 16, 30, 63, 64, 127, 128, 255}) {
+            auto inside = [&](int i) { return lo <= i && i <= hi; };
+            CHECK(h.any_between(lo, hi) == any_of(v.begin(), v.end(), inside));
+        }
+    }
+
+    // the interval predicates use min / max / the bit words, the others the bins
+    for (int k : {-5, 0, 15, 16, 17, 18, 21, 30, 31, 64, 255, 300}) {
+        auto greater = [&](int i) { return i > k; };
+        auto less = [&](int i) { return i < k; };
+        auto equal_k = [&](int i) { return i == k; };
+        auto near_k = [&](int i) { return k - 2 <= i && i <= k + 2; };
+        CHECK(column.all_of(pred::x > k) == all_of(v.begin(), v.end(), greater));
+        CHECK(column.none_of(pred::x < k) == none_of(v.begin(), v.end(), less));
+        CHECK(column.all_of(pred::x < k) == all_of(v.begin(), v.end(), less));
+        CHECK(column.none_of(pred::x > k) == none_of(v.begin(), v.end(), greater));
+        CHECK(column.none_of(pred::x == k) == none_of(v.begin(), v.end(), equal_k));
+        CHECK(column.all_of(pred::x != k) == none_of(v.begin(), v.end(), equal_k));
+        CHECK(column.none_of(pred::between(k - 2, k + 2)) == none_of(v.begin(), v.end(), near_k));
+        CHECK(column.all_of(pred::between(k - 2, k + 2)) == all_of(v.begin(), v.end(), near_k));
+        CHECK(column.count_if(pred::x < k) == count_if(v.begin(), v.end(), less));
+        CHECK(column.count_if(!(pred::x == k)) == count_if(v.begin(), v.end(), [&](int i) { return i != k; }));
+    }
+    auto is_even = [](int i) { return i % 2 == 0; };
+    CHECK(column.count_if(pred::mod<2> == 0) == count_if(v.begin(), v.end(), is_even));
+    CHECK(column.none_of(pred::mod<2> == 0) == none_of(v.begin(), v.end(), is_even));
+}
+
+int main()
+{
+    mt19937 gen(206);
+    uniform_int_distribution<int> age(0, 255);
+
+    AgeColumn column;
+    vector<int> v;
+    column.enable_histogram();
+    check_histogram(column, v);
+
+    for (int i = 0; i < 500; i++) {
+        int a = i < 300 ? 16 + i % 15 : age(gen);
+        column.push_back(a);
+        v.push_back(a);
+    }
+    check_histogram(column, v);
+
+    // set() moves one student from one bin to another, including out of the min / max bins
+    int lowest = *min_element(v.begin(), v.end());
+    for (size_t i = 0; i < v.size(); i++) {
+        if (v[i] == lowest) {
+            column.set(i, 200);
+            v[i] = 200;
+        }
+    }
+    column.set(7, 255);
+    v[7] = 255;
+    check_histogram(column, v);
+
+    column.erase(column.begin() + 5);
+    v.erase(v.begin() + 5);
+    column.erase(column.begin() + 20, column.begin() + 120);
+    v.erase(v.begin() + 20, v.begin() + 120);
+    check_histogram(column, v);
+
+    while (v.size() > 3) {
+        column.pop_back();
+        v.pop_back();
+    }
+    check_histogram(column, v);
+    while (!v.empty()) {
+        column.pop_back();
+        v.pop_back();
+    }
+    check_histogram(column, v);
+
+    // a histogram enabled later is built from the ages already there
+    column.disable_histogram();
+    for (int a : {18, 17, 21, 18, 21}) {
+        column.push_back(a);
+        v.push_back(a);
+    }
+    column.enable_histogram();
+    check_histogram(column, v);
+    column.clear();
+    v.clear();
+    check_histogram(column, v);
+
+    return check_report();
+}
@@ -0,0 +1,166 @@
+// age_loader_test - every text loader must read back the numbers that were written
+
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../age_loader.h"
+#include "check.h"
+using namespace std;
+
+const string path = "age_loader_test.txt";
+
+void write_text(const string& text)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    CHECK(f != nullptr);
+    if (f) {
+        fwrite(text.data(), 1, text.size(), f);
+        fclose(f);
+    }
+}
+
+// the sequential, parallel and async loaders all give "expected"
+void check_loaders(const string& text, const vector<int>& expected)
+{
+    write_text(text);
+    vector<int> loaded = {1, 2, 3};     // the loaders clear the vector first
+    LoadStats stats = load_ages_text(path, loaded);
+    CHECK(loaded == expected);
+    CHECK(stats.bytes == text.size() && stats.values == expected.size());
+
+    loaded = {1, 2, 3};
+    stats = load_ages_text_parallel(path, loaded);
+    CHECK(loaded == expected);
+    CHECK(stats.values == expected.size());
+
+    // read_blocks() rounds the block size up to whole 4096-byte pages, so
+    // the texts below that are longer than that are cut at byte 4096 (8192 ...)
+    for (size_t block : {size_t(4096), size_t(3 * 4096), size_t(1) << 20}) {
+        AsyncReadOptions options;
+        options.block_size = block;
+        loaded = {1, 2, 3};
+        stats = load_ages_text_async(path, loaded, options);
+        CHECK(loaded == expected);
+        CHECK(stats.values == expected.size());
+        CHECK(loaded.capacity() <= expected.size() + expected.size() / 8);     // no excess kept
+    }
+}
+
+// the loaders all reject "text"
+void check_rejected(const string& text)
+{
+    write_text(text);
+    vector<int> loaded;
+    int throws = 0;
+    try {
+        load_ages_text(path, loaded);
+    } catch (const runtime_error&) {
+        throws++;
+    }
+    try {
+        load_ages_text_parallel(path, loaded);
+    } catch (const runtime_error&) {
+        throws++;
+    }
+    try {
+        AsyncReadOptions options;
+        options.block_size = 4096;
+        load_ages_text_async(path, loaded, options);
+    } catch (const runtime_error&) {
+        throws++;
+    }
+    CHECK(throws == 3);
+}
+
+// Ages "18," up to a few bytes before byte 4096, where the first async
+// block ends, then "token" starting "before" bytes ahead of that end, so
+// it is cut in two by it, then more ages.  The ages around the token are
+// appended to "expected".
+string across_block_end(const string& token, size_t before, vector<int>& expected)
+{
+    const size_t end = 4096;
+    string text;
+    while (text.size() + 3 + before < end) {
+        text += "18,";
+        expected.push_back(18);
+    }
+    text.append(end - before - text.size(), ' ');      // spaces are separators
+    text += token + "\n";
+    return text;
+}
+
+void check_across_block_end()
+{
+    for (string number : {"7", "21", "12345678", "123456789", "2147483647", "-17", "-2147483648"}) {
+        // before = 0: the number starts the second block, otherwise it is cut
+        for (size_t before = 0; before < number.size() && before <= 8; before++) {
+            vector<int> expected;
+            string text = across_block_end(number, before, expected);
+            expected.push_back(stoi(number));
+            for (int i = 0; i < 2000; i++) {       // and on past the second block
+                text += "21\n";
+                expected.push_back(21);
+            }
+            check_loaders(text, expected);
+        }
+    }
+    for (string bad : {"1x7", "17x", "-x", "2147483648", "99999999999"}) {
+        for (size_t before = 1; before < bad.size(); before++) {
+            vector<int> ignored;
+            check_rejected(across_block_end(bad, before, ignored) + "18,17\n");
+        }
+    }
+}
+
+int main()
+{
+    check_loaders("", {});
+    check_loaders("18,17,21\n18,21\n", {18, 17, 21, 18, 21});
+    check_loaders("  18 ,\t17\r\n21", {18, 17, 21});
+    check_loaders("-5,0,007,2147483647,-2147483648\n", {-5, 0, 7, 2147483647, -2147483648});
+
+    // numbers of every length from 1 to 10 digits, so the 8-byte conversion
+    // sees each length, both inside the text and right at its end
+    mt19937 gen(206);
+    for (int digits = 1; digits <= 10; digits++) {
+        string text;
+        vector<int> expected;
+        long long low = 1, high = 9;
+        for (int d = 1; d < digits; d++) {
+            low *= 10;
+            high = high * 10 + 9;
+        }
+        uniform_int_distribution<long long> value(low, min(high, 2147483647LL));
+        for (int i = 0; i < 40; i++) {
+            long long v = value(gen);
+            expected.push_back(int(v));
+            text += to_string(v) + (i % 3 == 0 ? "," : "\n");
+        }
+        check_loaders(text, expected);
+        text.pop_back();        // the last number ends the file
+        check_loaders(text, expected);
+    }
+
+    // a file big enough to be cut into many parallel chunks and async blocks
+    string text;
+    vector<int> expected;
+    uniform_int_distribution<int> age(16, 30), wide(0, 99'999'999);
+    for (int i = 0; i < 200'000; i++) {
+        int v = i % 50 == 0 ? wide(gen) : age(gen);
+        expected.push_back(v);
+        text += to_string(v) + (i % 10 == 9 ? "\n" : ",");
+    }
+    check_loaders(text, expected);
+
+    check_rejected("18,17,x\n");
+    check_rejected("18,1a7\n");
+    check_rejected("2147483648\n");
+    check_rejected("12345678901234567890\n");
+    check_rejected("18,-,21");
+    check_across_block_end();
+
+    remove(path.c_str());
+    return check_report();
+}
@@ -0,0 +1,40 @@
+// check - the small test helpers shared by every test in tests/
+//
+// https://en.cppreference.com/w/cpp/error/assert
+
+#ifndef SAM206_TESTS_CHECK_H
+#define SAM206_TESTS_CHECK_H
+
+#include <iostream>
+
+/**
+ *  CHECK(condition)
+ *  Like assert(), but it is not removed in Release builds (NDEBUG), and a
+ *  failure does not stop the test: it is printed with its file and line,
+ *  and counted.  A test's main() ends with "return check_report();", which
+ *  fails the test if any CHECK failed.
+ */
+inline int& check_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline void check_failed(const char* condition, const char* file, int line)
+{
+    std::cerr << file << ':' << line << ": CHECK failed: " << condition << '\n';
+    ++check_failures();
+}
+
+#define CHECK(condition) ((condition) ? void() : check_failed(#condition, __FILE__, __LINE__))
+
+inline int check_report()
+{
+    if (check_failures() != 0) {
+        std::cerr << check_failures() << " check(s) failed\n";
+        return 1;
+    }
+    return 0;
+}
+
+#endif //SAM206_TESTS_CHECK_H
@@ -0,0 +1,232 @@
+// chunked_vector_test - ChunkedVector must behave like vector, whichever blocks it splits or merges
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "../chunked_vector.h"
+#include "check.h"
+using namespace std;
+
+constexpr size_t BLOCK = 8;     // small blocks, so a few dozen elements cross many boundaries
+using Chunked = ChunkedVector<int, BLOCK>;
+
+// the elements, the blocks they are kept in, and the iterators, against a vector
+void check_same(const Chunked& chunked, const vector<int>& v)
+{
+    CHECK(chunked.size() == v.size());
+    CHECK(chunked.empty() == v.empty());
+    CHECK(equal(chunked.begin(), chunked.end(), v.begin(), v.end()));
+    CHECK(chunked.end() - chunked.begin() == ptrdiff_t(v.size()));
+    for (size_t i = 0; i < v.size(); i++)
+        CHECK(chunked[i] == v[i]);
+
+    // blocks are never empty and never reach twice the block size, which
+    // is BLOCK until sqrt(n) passes 2 * BLOCK
+    size_t block = chunked.block_size();
+    CHECK(block >= BLOCK && (block == BLOCK || 4 * v.size() >= block * block));
+    CHECK(4 * block * block > v.size());
+    vector<int> joined;
+    size_t blocks = 0;
+    chunked.for_each_block([&](const int* data, size_t length) {
+        CHECK(length > 0 && length < 2 * block);
+        joined.insert(joined.end(), data, data + length);
+        blocks++;
+    });
+    CHECK(joined == v);
+    CHECK(blocks <= v.size());
+
+    // random access and walking backwards
+    if (!v.empty()) {
+        auto last = chunked.end();
+        --last;
+        CHECK(*last == v.back());
+        CHECK(chunked.begin()[ptrdiff_t(v.size() / 2)] == v[v.size() / 2]);
+        CHECK(*(chunked.end() - 1) == v.back());
+        vector<int> backwards;
+        for (auto it = chunked.end(); it != chunked.begin();)
+            backwards.push_back(*--it);
+        CHECK(equal(backwards.rbegin(), backwards.rend(), v.begin(), v.end()));
+    }
+}
+
+void check_algorithms(const Chunked& chunked, const vector<int>& v)
+{
+    auto under18 = [](int i) { return i < 18; };
+    CHECK(count(chunked.begin(), chunked.end(), 21) == count(v.begin(), v.end(), 21));
+    CHECK(count_if(chunked.begin(), chunked.end(), under18) == count_if(v.begin(), v.end(), under18));
+    CHECK(find(chunked.begin(), chunked.end(), 30) - chunked.begin() == find(v.begin(), v.end(), 30) - v.begin());
+    CHECK(lower_bound(chunked.begin(), chunked.end(), 0) == chunked.begin() + (lower_bound(v.begin(), v.end(), 0) - v.begin()));
+}
+
+int main()
+{
+    mt19937 gen(206);
+    uniform_int_distribution<int> age(16, 30);
+
+    Chunked chunked;
+    vector<int> v;
+    check_same(chunked, v);
+
+    for (int i = 0; i < 10 * int(BLOCK); i++) {
+        chunked.push_back(i);
+        v.push_back(i);
+    }
+    check_same(chunked, v);
+
+    // erase at every kind of block boundary: the first and last element of
+    // a block, the very first and last elements, until blocks merge
+    for (size_t at : {size_t(0), BLOCK, BLOCK - 1, 2 * BLOCK, 3 * BLOCK - 1, size_t(-1)}) {
+        at = min(at, v.size() - 1);
+        auto it = chunked.erase(chunked.begin() + ptrdiff_t(at));
+        auto v_it = v.erase(v.begin() + ptrdiff_t(at));
+        CHECK(it - chunked.begin() == v_it - v.begin());
+        CHECK(it == chunked.end() || *it == *v_it);
+        check_same(chunked, v);
+    }
+    // empty one block completely, one element at a time
+    for (size_t k = 0; k < BLOCK + 2; k++) {
+        auto it = chunked.erase(chunked.begin() + ptrdiff_t(BLOCK));
+        auto v_it = v.erase(v.begin() + ptrdiff_t(BLOCK));
+        CHECK(it - chunked.begin() == v_it - v.begin());
+        check_same(chunked, v);
+    }
+
+    // insert at block boundaries until blocks split
+    for (size_t k = 0; k < 3 * BLOCK; k++) {
+        size_t at = (k * BLOCK) % (v.size() + 1);
+        auto it = chunked.insert(chunked.begin() + ptrdiff_t(at), 100 + int(k));
+        auto v_it = v.insert(v.begin() + ptrdiff_t(at), 100 + int(k));
+        CHECK(it - chunked.begin() == v_it - v.begin());
+        CHECK(*it == *v_it);
+        check_same(chunked, v);
+    }
+    // insert repeatedly in one place - one block grows and splits again and again
+    for (int k = 0; k < 5 * int(BLOCK); k++) {
+        chunked.insert(chunked.begin() + 3, -k);
+        v.insert(v.begin() + 3, -k);
+    }
+    check_same(chunked, v);
+    chunked.insert(chunked.end(), 7);
+    v.insert(v.end(), 7);
+    check_same(chunked, v);
+
+    // ranges that start and end inside blocks, or span several blocks
+    for (auto [from, to] : {pair<size_t, size_t>{1, 3}, {BLOCK - 1, BLOCK + 1}, {2, 3 * BLOCK + 5},
+                            {0, BLOCK}, {5, 5}}) {
+        auto it = chunked.erase(chunked.begin() + ptrdiff_t(from), chunked.begin() + ptrdiff_t(to));
+        auto v_it = v.erase(v.begin() + ptrdiff_t(from), v.begin() + ptrdiff_t(to));
+        CHECK(it - chunked.begin() == v_it - v.begin());
+        check_same(chunked, v);
+    }
+    auto tail = chunked.erase(chunked.begin() + 4, chunked.end());
+    v.erase(v.begin() + 4, v.end());
+    CHECK(tail == chunked.end());
+    check_same(chunked, v);
+
+    // random operations, as main.cpp might do them
+    for (int step = 0; step < 5000; step++) {
+        int op = int(gen() % 6);
+        size_t at = v.empty() ? 0 : gen() % v.size();
+        if (op <= 1 || v.empty()) {
+            int a = age(gen);
+            chunked.insert(chunked.begin() + ptrdiff_t(at), a);
+            v.insert(v.begin() + ptrdiff_t(at), a);
+        } else if (op == 2) {
+            int a = age(gen);
+            chunked.push_back(a);
+            v.push_back(a);
+        } else if (op == 3) {
+            chunked.erase(chunked.begin() + ptrdiff_t(at));
+            v.erase(v.begin() + ptrdiff_t(at));
+        } else if (op == 4) {
+            size_t to = min(v.size(), at + gen() % (3 * BLOCK));
+            chunked.erase(chunked.begin() + ptrdiff_t(at), chunked.begin() + ptrdiff_t(to));
+            v.erase(v.begin() + ptrdiff_t(at), v.begin() + ptrdiff_t(to));
+        } else {
+            chunked.pop_back();
+            v.pop_back();
+        }
+        if (step % 97 == 0) {
+            check_same(chunked, v);
+            check_algorithms(chunked, v);
+        }
+    }
+    check_same(chunked, v);
+
+    // erase every even age, the way main.cpp does
+    for (auto it = chunked.begin(); it != chunked.end();)
+        it = (*it % 2 == 0) ? chunked.erase(it) : it + 1;
+    v.erase(remove_if(v.begin(), v.end(), [](int i) { return i % 2 == 0; }), v.end());
+    check_same(chunked, v);
+
+    // sort through the iterators, then binary search
+    sort(chunked.begin(), chunked.end());
+    sort(v.begin(), v.end());
+    check_same(chunked, v);
+    check_algorithms(chunked, v);
+
+    bool threw = false;
+    try {
+        chunked.at(chunked.size());
+    } catch (const out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    while (!v.empty()) {
+        chunked.pop_back();
+        v.pop_back();
+    }
+    check_same(chunked, v);
+
+    // the block size follows sqrt(n) up, and back down to BLOCK
+    for (int i = 0; i < 100'000; i++) {
+        chunked.push_back(i);
+        v.push_back(i);
+        if ((i & (i + 1)) == 0)     // at every power of 2
+            check_same(chunked, v);
+    }
+    check_same(chunked, v);
+    CHECK(chunked.block_size() >= 128);
+    for (int k = 0; k < 500; k++) {
+        size_t at = gen() % v.size();
+        chunked.insert(chunked.begin() + ptrdiff_t(at), -k);
+        v.insert(v.begin() + ptrdiff_t(at), -k);
+        at = gen() % v.size();
+        chunked.erase(chunked.begin() + ptrdiff_t(at));
+        v.erase(v.begin() + ptrdiff_t(at));
+    }
+    check_same(chunked, v);
+    chunked.erase(chunked.begin() + 10, chunked.end() - 10);
+    v.erase(v.begin() + 10, v.end() - 10);
+    check_same(chunked, v);
+    CHECK(chunked.block_size() == BLOCK);
+    while (v.size() > 1) {
+        chunked.erase(chunked.begin());
+        v.erase(v.begin());
+    }
+    check_same(chunked, v);
+    chunked.clear();
+    v.clear();
+    check_same(chunked, v);
+
+    // the default block size, and the comparisons
+    ChunkedVector<int> big;
+    for (int i = 0; i < 5000; i++) {
+        big.push_back(i % 15 + 16);
+        v.push_back(i % 15 + 16);
+    }
+    big.erase(big.begin() + 1024);
+    v.erase(v.begin() + 1024);
+    big.erase(big.begin() + 1000, big.begin() + 3000);
+    v.erase(v.begin() + 1000, v.begin() + 3000);
+    CHECK(big.size() == v.size() && equal(big.begin(), big.end(), v.begin()));
+    Chunked smaller = {18, 17, 21};
+    Chunked larger = {18, 17, 22};
+    CHECK(smaller == Chunked({18, 17, 21}));
+    CHECK(smaller < larger);
+    CHECK(smaller != larger);
+
+    return check_report();
+}
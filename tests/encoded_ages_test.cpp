@@ -0,0 +1,227 @@
+// encoded_ages_test - RunLengthAges and DictionaryAges must behave like vector<int>,
+// however their runs and dictionary entries come and go
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "../encoded_ages.h"
+#include "check.h"
+using namespace std;
+using pred::x;
+
+// the elements through operator[], at() and the iterators, forwards,
+// backwards and in jumps, against a vector
+template <typename Ages>
+void check_same(const Ages& ages, const vector<int>& v, mt19937& gen)
+{
+    CHECK(ages.size() == v.size());
+    CHECK(ages.empty() == v.empty());
+    CHECK(equal(ages.begin(), ages.end(), v.begin(), v.end()));
+    CHECK(ages.end() - ages.begin() == ptrdiff_t(v.size()));
+    for (size_t i = 0; i < v.size(); i++)
+        CHECK(ages[i] == v[i] && ages.at(i) == v[i]);
+
+    vector<int> backwards;
+    for (auto it = ages.end(); it != ages.begin();)
+        backwards.push_back(*--it);
+    CHECK(equal(backwards.rbegin(), backwards.rend(), v.begin(), v.end()));
+
+    // jump, then step both ways from where the jump landed
+    if (!v.empty()) {
+        auto it = ages.begin();
+        ptrdiff_t i = 0;
+        for (int k = 0; k < 50; k++) {
+            ptrdiff_t to = ptrdiff_t(gen() % v.size());
+            it += to - i;
+            i = to;
+            CHECK(*it == v[size_t(i)] && it - ages.begin() == i);
+            if (i + 1 < ptrdiff_t(v.size())) {
+                ++it;
+                CHECK(*it == v[size_t(i) + 1]);
+                --it;
+            }
+            if (i > 0) {
+                --it;
+                CHECK(*it == v[size_t(i) - 1]);
+                it++;
+            }
+            CHECK(*it == v[size_t(i)] && it[0] == v[size_t(i)]);
+        }
+        it -= i;
+        CHECK(it == ages.begin());
+        CHECK(*(ages.end() - 1) == v.back());
+    }
+
+    bool threw = false;
+    try {
+        ages.at(v.size());
+    } catch (const out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+// count_if, find_if, all_of and none_of give what pred:: gives on the vector
+template <typename Ages, typename P>
+void check_predicate(const Ages& ages, const vector<int>& v, const pred::Expr<P>& e)
+{
+    CHECK(ages.count_if(e) == pred::count_if(v.begin(), v.end(), e));
+    CHECK(ages.find_if(e) - ages.begin() == pred::find_if(v.begin(), v.end(), e) - v.begin());
+    CHECK(ages.all_of(e) == pred::all_of(v.begin(), v.end(), e));
+    CHECK(ages.none_of(e) == pred::none_of(v.begin(), v.end(), e));
+}
+
+template <typename Ages>
+void check_queries(const Ages& ages, const vector<int>& v)
+{
+    for (int age : {16, 18, 21, 30, 99}) {
+        CHECK(ages.count(age) == count(v.begin(), v.end(), age));
+        CHECK(ages.find(age) - ages.begin() == find(v.begin(), v.end(), age) - v.begin());
+    }
+    check_predicate(ages, v, x < 18);
+    check_predicate(ages, v, x > 16 && x < 30);
+    check_predicate(ages, v, !(x == 21));
+    check_predicate(ages, v, pred::mod<2> == 0);
+    check_predicate(ages, v, x >= 0);
+}
+
+// random push_back and pop_back, with ages that come in runs
+template <typename Ages>
+void check_random(Ages& ages, vector<int>& v, mt19937& gen)
+{
+    uniform_int_distribution<int> age(16, 30);
+    for (int step = 0; step < 3000; step++) {
+        if (v.empty() || gen() % 3 != 0) {
+            int a = gen() % 2 == 0 && !v.empty() ? v.back() : age(gen);
+            ages.push_back(a);
+            v.push_back(a);
+        } else {
+            ages.pop_back();
+            v.pop_back();
+        }
+        if (step % 250 == 0) {
+            check_same(ages, v, gen);
+            check_queries(ages, v);
+        }
+    }
+    check_same(ages, v, gen);
+    check_queries(ages, v);
+    CHECK(Ages(v) == ages);
+}
+
+void check_run_length(mt19937& gen)
+{
+    RunLengthAges ages = {18, 18, 18, 17, 17, 21, 21, 21, 21};
+    vector<int> v = {18, 18, 18, 17, 17, 21, 21, 21, 21};
+    CHECK(ages.runs() == 3 && ages.run_age(1) == 17 && ages.run_length(1) == 2);
+    check_same(ages, v, gen);
+    check_queries(ages, v);
+
+    // popping the last age of a run removes the run ...
+    ages.push_back(30);
+    ages.pop_back();
+    CHECK(ages.runs() == 3 && ages == RunLengthAges(v));
+    for (int k = 0; k < 4; k++) {
+        ages.pop_back();
+        v.pop_back();
+    }
+    CHECK(ages.runs() == 2 && ages.run_length(1) == 2);
+    check_same(ages, v, gen);
+    check_queries(ages, v);
+    // ... so the next equal age joins the run before it again
+    ages.push_back(17);
+    v.push_back(17);
+    CHECK(ages.runs() == 2 && ages.run_length(1) == 3);
+    check_same(ages, v, gen);
+
+    // operator== compares the runs: equal ages in the same order are equal
+    CHECK(ages == RunLengthAges({18, 18, 18, 17, 17, 17}));
+    CHECK(!(ages == RunLengthAges({18, 18, 17, 17, 17, 17})));
+    CHECK(!(ages == RunLengthAges({18, 18, 18, 17, 17})));
+    CHECK(!(RunLengthAges() == RunLengthAges({21})));
+
+    while (!v.empty()) {
+        ages.pop_back();
+        v.pop_back();
+    }
+    CHECK(ages.runs() == 0 && ages == RunLengthAges());
+    check_same(ages, v, gen);
+    check_random(ages, v, gen);
+}
+
+void check_dictionary(mt19937& gen)
+{
+    DictionaryAges ages = {18, 17, 21, 18, 21};
+    vector<int> v = {18, 17, 21, 18, 21};
+    CHECK(ages.distinct() == 3 && ages.dictionary_age(2) == 21 && ages.dictionary_count(2) == 2);
+    check_same(ages, v, gen);
+    check_queries(ages, v);
+
+    // an entry stays when its last age is popped, with a count of 0, and
+    // find must not report it
+    ages.push_back(30);
+    ages.pop_back();
+    CHECK(ages.distinct() == 4 && ages.dictionary_count(3) == 0);
+    CHECK(ages.find(30) == ages.end());
+    CHECK(ages.find_if(x >= 30) == ages.end());
+    CHECK(ages.find_if(x > 20) - ages.begin() == 2);
+    CHECK(ages.none_of(x == 30) && ages.count(30) == 0);
+    check_same(ages, v, gen);
+    check_queries(ages, v);
+    for (int k = 0; k < 4; k++) {       // 17 goes to a count of 0 as well
+        ages.pop_back();
+        v.pop_back();
+    }
+    CHECK(ages.dictionary_count(1) == 0);
+    CHECK(ages.find(17) == ages.end() && ages.find_if(x < 18) == ages.end());
+    check_queries(ages, v);
+    ages.push_back(30);                 // the entry is used again
+    v.push_back(30);
+    CHECK(ages.distinct() == 4 && ages.dictionary_count(3) == 1);
+    CHECK(ages.find(30) - ages.begin() == 1);
+    check_same(ages, v, gen);
+    check_queries(ages, v);
+
+    // equal ages are equal, whatever codes they were given
+    DictionaryAges reordered = {30, 17, 18};     // 18 gets code 2 here, code 0 in "ages"
+    for (int k = 0; k < 3; k++)
+        reordered.pop_back();
+    reordered.push_back(18);
+    reordered.push_back(30);
+    CHECK(reordered == ages);
+
+    // 256 distinct ages fit, the 257th throws and changes nothing
+    DictionaryAges wide;
+    vector<int> w;
+    for (int a = 0; a < int(DictionaryAges::MAX_DISTINCT); a++) {
+        wide.push_back(a * 7 - 300);
+        w.push_back(a * 7 - 300);
+    }
+    wide.push_back(-300);
+    w.push_back(-300);
+    bool threw = false;
+    try {
+        wide.push_back(9999);
+    } catch (const out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(wide.distinct() == DictionaryAges::MAX_DISTINCT);
+    check_same(wide, w, gen);
+    CHECK(wide.count(1485) == 1 && wide.find(1485) - wide.begin() == 255);
+    CHECK(wide.count(-300) == 2);
+
+    ages.clear();
+    v.clear();
+    check_same(ages, v, gen);
+    check_random(ages, v, gen);
+}
+
+int main()
+{
+    mt19937 gen(206);
+    check_run_length(gen);
+    check_dictionary(gen);
+    return check_report();
+}
@@ -0,0 +1,164 @@
+// lotto_test - every scoring code path must give the same answers as popcount,
+// and ticket_mask() and LottoTicket must accept the same tickets
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "../lotto.h"
+#include "check.h"
+using namespace std;
+
+// a random ticket: LOTTO_NUMBERS different bits out of 64
+TicketMask random_ticket(mt19937_64& gen)
+{
+    TicketMask mask = 0;
+    while (__builtin_popcountll(mask) < LOTTO_NUMBERS)
+        mask |= TicketMask(1) << (gen() % LOTTO_MAX);
+    return mask;
+}
+
+void check_paths(const vector<TicketMask>& tickets, TicketMask draw)
+{
+    PrizeTiers expected;
+    vector<uint8_t> expected_matches(tickets.size());
+    for (size_t i = 0; i < tickets.size(); i++) {
+        expected_matches[i] = uint8_t(match_count(tickets[i], draw));
+        expected.tickets_matching[expected_matches[i]]++;
+    }
+    CHECK(score_tickets(tickets, draw).tickets_matching == expected.tickets_matching);
+    vector<uint8_t> matches(tickets.size());
+    match_counts(tickets.data(), tickets.size(), draw, matches.data());
+    CHECK(matches == expected_matches);
+
+    int paths = 0;
+    for (const char* isa : {"scalar", "avx2", "avx512"}) {
+        PrizeTiers tiers;
+        vector<uint8_t> path_matches(tickets.size());
+        if (!score_tickets_using(isa, tickets.data(), tickets.size(), draw, tiers, path_matches.data()))
+            continue;
+        paths++;
+        CHECK(tiers.tickets_matching == expected.tickets_matching);
+        CHECK(path_matches == expected_matches);
+    }
+    CHECK(paths >= 1);      // scalar always runs
+}
+
+bool draw_rejected(TicketMask draw)
+{
+    vector<TicketMask> tickets(20, ~TicketMask(0));
+    try {
+        score_tickets(tickets, draw);
+    } catch (const invalid_argument&) {
+        try {
+            vector<uint8_t> matches(tickets.size());
+            match_counts(tickets.data(), tickets.size(), draw, matches.data());
+        } catch (const invalid_argument&) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ticket_mask() and every LottoTicket constructor apply one rule
+bool rejected(const vector<int>& numbers)
+{
+    int throws = 0;
+    try {
+        ticket_mask(numbers);
+    } catch (const invalid_argument&) {
+        throws++;
+    }
+    try {
+        LottoTicket ticket(numbers);
+    } catch (const invalid_argument&) {
+        throws++;
+    }
+    try {
+        LottoTicket ticket(numbers.data(), numbers.data() + numbers.size());
+    } catch (const invalid_argument&) {
+        throws++;
+    }
+    CHECK(throws == 0 || throws == 3);
+    return throws == 3;
+}
+
+void check_tickets()
+{
+    CHECK(!rejected(vector<int>{2, 10, 13, 22, 35, 47}));
+    CHECK(!rejected(vector<int>{64, 1, 63, 2, 62, 3}));
+    CHECK(rejected(vector<int>{}));
+    CHECK(rejected(vector<int>{2, 10, 13, 22, 35}));              // too few
+    CHECK(rejected(vector<int>{2, 10, 13, 22, 35, 47, 50}));      // too many
+    CHECK(rejected(vector<int>{2, 10, 13, 22, 35, 35}));          // a repeat
+    CHECK(rejected(vector<int>{0, 10, 13, 22, 35, 47}));          // out of range
+    CHECK(rejected(vector<int>{2, 10, 13, 22, 35, 65}));
+
+    LottoTicket ticket = {47, 35, 22, 13, 10, 2};
+    CHECK(ticket.mask() == ticket_mask({2, 10, 13, 22, 35, 47}));
+    CHECK(ticket == LottoTicket(vector<int>{2, 10, 13, 22, 35, 47}));
+    CHECK(ticket.size() == LOTTO_NUMBERS);
+    const int sorted[] = {2, 10, 13, 22, 35, 47};
+    for (int i = 0; i < LOTTO_NUMBERS; i++)
+        CHECK(ticket[i] == sorted[i]);
+    CHECK(ticket.match_count(LottoTicket{2, 10, 13, 1, 3, 4}) == 3);
+    CHECK(!(ticket == LottoTicket{2, 10, 13, 22, 35, 48}));
+
+    bool threw = false;
+    try {
+        (void)LottoTicket{2, 2, 13, 22, 35, 47};
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    vector<LottoTicket> tickets = {ticket, {1, 2, 3, 4, 5, 6}, {2, 47, 10, 35, 13, 22}, {6, 5, 4, 3, 2, 1}};
+    CHECK(count_duplicate_tickets(tickets) == 2);
+}
+
+int main()
+{
+    check_tickets();
+
+    mt19937_64 gen(206);
+
+    // lengths around the 4 and 8 ticket vector loops and their scalar tails
+    for (size_t n : {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 1000}) {
+        vector<TicketMask> tickets(n);
+        for (TicketMask& t : tickets)
+            t = random_ticket(gen);
+        TicketMask draw = random_ticket(gen);
+        check_paths(tickets, draw);
+
+        // every tier filled: ticket i shares i % 7 numbers with the draw
+        for (size_t i = 0; i < n; i++) {
+            TicketMask t = 0;
+            int shared = int(i % (LOTTO_NUMBERS + 1));
+            for (TicketMask rest = draw; shared > 0; rest &= rest - 1, shared--)
+                t |= rest & -rest;
+            tickets[i] = t;
+        }
+        check_paths(tickets, draw);
+        check_paths(tickets, 0);
+    }
+
+    // tickets that break the rules still score, the draw limits the matches
+    vector<TicketMask> odd = {~TicketMask(0), 0, 1, TicketMask(1) << 63, 0xFFFF'0000'0000'0000ull};
+    check_paths(odd, random_ticket(gen));
+    check_paths(odd, 0x8000'0000'0000'0001ull);
+
+    // a draw with more than LOTTO_NUMBERS numbers has no tier for its matches
+    CHECK(draw_rejected(~TicketMask(0)));
+    CHECK(draw_rejected(0x7F));
+    CHECK(!draw_rejected(0x3F));
+    PrizeTiers tiers;
+    bool threw = false;
+    try {
+        score_tickets_using("scalar", odd.data(), odd.size(), 0x7F, tiers, nullptr);
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    return check_report();
+}
@@ -0,0 +1,123 @@
+// observed_vector_test - ObservedVector's statistics must match <algorithm> on its elements
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "../observed_vector.h"
+#include "check.h"
+using namespace std;
+
+auto under18 = [](int i) { return i < 18; };
+auto over16 = [](int i) { return i > 16; };
+auto is_30 = [](int i) { return i == 30; };
+
+struct Watched {
+    ObservedVector::WatchId under18, over16, is_30;
+};
+
+void check_statistics(const ObservedVector& observed, const vector<int>& v, const Watched& w)
+{
+    CHECK(observed.vector() == v);
+    CHECK(equal(observed.begin(), observed.end(), v.begin(), v.end()));
+    CHECK(observed.size() == v.size());
+    CHECK(observed.empty() == v.empty());
+    CHECK(observed.sum() == accumulate(v.begin(), v.end(), 0LL));
+    size_t evens = size_t(count_if(v.begin(), v.end(), [](int i) { return i % 2 == 0; }));
+    CHECK(observed.even_count() == evens);
+    CHECK(observed.odd_count() == v.size() - evens);
+
+    if (v.empty()) {
+        bool threw = false;
+        try {
+            observed.min();
+        } catch (const out_of_range&) {
+            threw = true;
+        }
+        CHECK(threw);
+    } else {
+        CHECK(observed.min() == *min_element(v.begin(), v.end()));
+        CHECK(observed.max() == *max_element(v.begin(), v.end()));
+    }
+
+    CHECK(observed.count_matching(w.under18) == size_t(count_if(v.begin(), v.end(), under18)));
+    CHECK(observed.none_of(w.under18) == none_of(v.begin(), v.end(), under18));
+    CHECK(observed.all_of(w.over16) == all_of(v.begin(), v.end(), over16));
+    CHECK(observed.any_of(w.is_30) == any_of(v.begin(), v.end(), is_30));
+    CHECK(observed.count_matching(w.is_30) == size_t(count(v.begin(), v.end(), 30)));
+}
+
+int main()
+{
+    mt19937 gen(206);
+    uniform_int_distribution<int> age(16, 30);
+
+    ObservedVector observed;
+    vector<int> v;
+    // one predicate watched before any element is added
+    Watched w;
+    w.under18 = observed.watch(under18);
+    for (int i = 0; i < 1000; i++) {
+        int a = age(gen);
+        observed.push_back(a);
+        v.push_back(a);
+    }
+    // and two watched afterwards, counted from the elements already there
+    w.over16 = observed.watch(over16);
+    w.is_30 = observed.watch(is_30);
+    check_statistics(observed, v, w);
+
+    // set() the smallest and largest elements away, so min / max must move
+    int lowest = *min_element(v.begin(), v.end());
+    int highest = *max_element(v.begin(), v.end());
+    for (size_t i = 0; i < v.size(); i++) {
+        if (v[i] == lowest || v[i] == highest) {
+            observed.set(i, 20);
+            v[i] = 20;
+        }
+    }
+    check_statistics(observed, v, w);
+    observed.set(3, -7);
+    v[3] = -7;
+    observed.set(4, 99);
+    v[4] = 99;
+    check_statistics(observed, v, w);
+
+    auto erased = observed.erase(observed.begin() + 3);
+    auto v_erased = v.erase(v.begin() + 3);
+    CHECK(erased - observed.begin() == v_erased - v.begin());
+    erased = observed.erase(observed.begin() + 100, observed.begin() + 300);
+    v_erased = v.erase(v.begin() + 100, v.begin() + 300);
+    CHECK(erased - observed.begin() == v_erased - v.begin());
+    check_statistics(observed, v, w);
+
+    // erase every even age, the way main.cpp does
+    for (auto it = observed.begin(); it != observed.end();)
+        it = (*it % 2 == 0) ? observed.erase(it) : it + 1;
+    v.erase(remove_if(v.begin(), v.end(), [](int i) { return i % 2 == 0; }), v.end());
+    check_statistics(observed, v, w);
+
+    while (v.size() > 1) {
+        observed.pop_back();
+        v.pop_back();
+    }
+    check_statistics(observed, v, w);
+    observed.pop_back();
+    v.pop_back();
+    check_statistics(observed, v, w);
+
+    for (int a : {18, 17, 21, 18, 21}) {
+        observed.push_back(a);
+        v.push_back(a);
+    }
+    check_statistics(observed, v, w);
+    observed.clear();
+    v.clear();
+    check_statistics(observed, v, w);
+
+    ObservedVector listed = {18, 17, 21};
+    CHECK(listed.sum() == 56 && listed.min() == 17 && listed.max() == 21 && listed.odd_count() == 2);
+
+    return check_report();
+}
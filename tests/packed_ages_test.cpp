@@ -0,0 +1,200 @@
+// packed_ages_test - PackedAges must read back every age it was given, whatever bits it packs
+// them in, and its range queries on the packed codes must agree with pred:: on a vector
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "../packed_ages.h"
+#include "check.h"
+using namespace std;
+
+constexpr size_t SEGMENT = PackedAges::SEGMENT;
+
+// operator[], at(), the iterators, decode() and to_vector(), against a vector
+void check_same(const PackedAges& packed, const vector<int>& v)
+{
+    CHECK(packed.size() == v.size());
+    CHECK(packed.empty() == v.empty());
+    CHECK(packed.segments() == v.size() / SEGMENT);
+    CHECK(packed.to_vector() == v);
+    CHECK(equal(packed.begin(), packed.end(), v.begin(), v.end()));
+    CHECK(packed.end() - packed.begin() == ptrdiff_t(v.size()));
+    for (size_t i = 0; i < v.size(); i++)
+        CHECK(packed[i] == v[i]);
+    if (!v.empty()) {
+        CHECK(packed.at(v.size() - 1) == v.back());
+        CHECK(*(packed.end() - 1) == v.back());
+    }
+    vector<int> segment(SEGMENT);
+    for (size_t s = 0; s < packed.segments(); s++) {
+        packed.decode(s, segment.data());
+        CHECK(equal(segment.begin(), segment.end(), v.begin() + ptrdiff_t(s * SEGMENT)));
+    }
+}
+
+// SEGMENT ages from lo to lo + 2^bits - 1, both ends included, so the
+// segment needs exactly "bits" bits
+vector<int> spread(unsigned bits, int lo, mt19937& gen)
+{
+    uint32_t top = bits == 32 ? UINT32_MAX : (uint32_t(1) << bits) - 1;
+    uniform_int_distribution<uint32_t> code(0, top);
+    vector<int> ages(SEGMENT);
+    for (int& a : ages)
+        a = int(uint32_t(lo) + code(gen));
+    ages[gen() % SEGMENT] = lo;
+    ages[gen() % SEGMENT] = int(uint32_t(lo) + top);
+    return ages;
+}
+
+// count_if, find_if, all_of and none_of on the packed codes (or, for
+// predicates with no range, on the unpacked ages) give what pred:: gives
+// on the vector
+template <typename P>
+void check_predicate(const PackedAges& packed, const vector<int>& v, const pred::Expr<P>& e)
+{
+    CHECK(packed.count_if(e) == pred::count_if(v.begin(), v.end(), e));
+    CHECK(packed.find_if(e).index() == size_t(pred::find_if(v.begin(), v.end(), e) - v.begin()));
+    CHECK(packed.all_of(e) == pred::all_of(v.begin(), v.end(), e));
+    CHECK(packed.none_of(e) == pred::none_of(v.begin(), v.end(), e));
+}
+
+// Segments that lie wholly inside or outside the ranges below, segments
+// that straddle them, and a tail
+void check_ranges(mt19937& gen)
+{
+    using pred::x;
+    uniform_int_distribution<int> age(16, 30);
+    vector<int> v;
+    auto add_segment = [&](int lo, int hi) {
+        uniform_int_distribution<int> a(lo, hi);
+        for (size_t i = 0; i < SEGMENT; i++)
+            v.push_back(a(gen));
+    };
+    add_segment(50, 60);
+    add_segment(21, 21);            // 0 bits
+    add_segment(16, 30);
+    add_segment(20, 25);
+    add_segment(INT_MIN, INT_MAX);
+    add_segment(-5, 3);
+    for (int i = 0; i < 300; i++)
+        v.push_back(age(gen));
+    v[3 * SEGMENT + 700] = 19;      // so the 20..25 segment straddles x < 20
+    v[4 * SEGMENT + 5] = INT_MIN;
+    v[4 * SEGMENT + 9] = INT_MAX;
+    PackedAges packed(v);
+    check_same(packed, v);
+
+    for (int age : {16, 19, 21, 30, 55, 99, INT_MIN, INT_MAX}) {
+        CHECK(packed.count(age) == count(v.begin(), v.end(), age));
+        CHECK(packed.find(age).index() == size_t(find(v.begin(), v.end(), age) - v.begin()));
+    }
+    check_predicate(packed, v, x < 18);
+    check_predicate(packed, v, x >= 50);
+    check_predicate(packed, v, x == 19);
+    check_predicate(packed, v, x < 20 && x > 18);
+    check_predicate(packed, v, x != 21);                    // outside, skips the 0-bit segment
+    check_predicate(packed, v, pred::between(20, 25));
+    check_predicate(packed, v, pred::between(25, 20));      // lo > hi wraps: outside 21..24
+    check_predicate(packed, v, pred::between(60, 16));      // outside 17..59
+    check_predicate(packed, v, x < INT_MIN);                // empty
+    check_predicate(packed, v, x > INT_MAX);                // empty
+    check_predicate(packed, v, !(x < INT_MIN));             // everything
+    check_predicate(packed, v, x <= INT_MAX);
+    check_predicate(packed, v, x >= INT_MIN);
+    check_predicate(packed, v, !(x < 18));
+    check_predicate(packed, v, !pred::between(16, 60));
+    check_predicate(packed, v, !pred::between(21, 60));         // find skips two whole segments
+    check_predicate(packed, v, x > 16 && x < 30);
+    check_predicate(packed, v, x >= 20 && x <= 25 && x != 99);      // no range: unpacked
+    check_predicate(packed, v, pred::between(0, 30) && pred::between(20, 60));
+    check_predicate(packed, v, x > 30 && x < 16);                   // empty
+    check_predicate(packed, v, x != 21 || x != 22);                 // everything
+    check_predicate(packed, v, !pred::between(16, 30) || !pred::between(20, 60));
+    check_predicate(packed, v, !pred::between(20, 25) || x < INT_MIN);   // inside and outside: unpacked
+    check_predicate(packed, v, x < 18 || x > 25);                   // not one range: unpacked
+    check_predicate(packed, v, pred::mod<2> == 0);
+}
+
+int main()
+{
+    mt19937 gen(206);
+
+    // every bit width, one segment each, then all of them one after another
+    vector<int> all;
+    for (unsigned bits = 0; bits <= 32; bits++) {
+        for (int lo : {16, -1000, INT_MIN}) {
+            if (bits >= 31 && lo != INT_MIN)
+                continue;       // lo + 2^bits - 1 would not be an int
+            vector<int> v = spread(bits, lo, gen);
+            PackedAges packed(v);
+            CHECK(packed.segments() == 1 && packed.segment_bits(0) == bits);
+            check_same(packed, v);
+            if (lo == INT_MIN)
+                all.insert(all.end(), v.begin(), v.end());
+        }
+    }
+    PackedAges widths(all);
+    for (unsigned bits = 0; bits <= 32; bits++)
+        CHECK(widths.segment_bits(bits) == bits);
+    check_same(widths, all);
+    CHECK(*min_element(widths.begin(), widths.end()) == INT_MIN);
+    CHECK(*max_element(widths.begin(), widths.end()) == INT_MAX);
+
+    // sizes around the segment boundary: nothing packed, all packed, a tail
+    uniform_int_distribution<int> age(16, 30);
+    for (size_t n : {size_t(0), size_t(1), SEGMENT - 1, SEGMENT, SEGMENT + 1, 5 * SEGMENT + 17}) {
+        vector<int> v(n);
+        for (int& a : v)
+            a = age(gen);
+        PackedAges packed(v);
+        check_same(packed, v);
+        PackedAges pushed;
+        for (int a : v)
+            pushed.push_back(a);
+        CHECK(pushed == packed);
+    }
+
+    // pop_back unpacks the last segment, push_back packs it again
+    vector<int> v(3 * SEGMENT);
+    for (int& a : v)
+        a = age(gen);
+    PackedAges packed(v);
+    packed.pop_back();
+    v.pop_back();
+    check_same(packed, v);
+    CHECK(packed.segments() == 2);
+    packed.push_back(-7);       // a wider segment than before
+    v.push_back(-7);
+    check_same(packed, v);
+    CHECK(packed.segments() == 3);
+    for (size_t k = 0; k < SEGMENT + 5; k++) {      // across two boundaries
+        packed.pop_back();
+        v.pop_back();
+    }
+    check_same(packed, v);
+    for (size_t k = 0; k < 2 * SEGMENT; k++) {
+        packed.push_back(int(k));
+        v.push_back(int(k));
+    }
+    check_same(packed, v);
+    while (!v.empty()) {
+        packed.pop_back();
+        v.pop_back();
+    }
+    check_same(packed, v);
+
+    check_ranges(gen);
+
+    CHECK(PackedAges({18, 17, 21}).memory_bytes() == 3 * sizeof(int));
+    bool threw = false;
+    try {
+        packed.at(0);
+    } catch (const out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    return check_report();
+}
@@ -0,0 +1,112 @@
+// parallel_test - the par:: algorithms must give the same answers as <algorithm>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "../parallel.h"
+#include "check.h"
+using namespace std;
+
+// Chunks must cover [first, last) in order, with cache-line aligned inner boundaries
+void check_chunks(const int* first, const int* last, unsigned threads)
+{
+    par::Chunks chunks(first, last, threads);
+    CHECK(chunks.size() >= 1);
+    CHECK(chunks.begin(0) == first);
+    CHECK(chunks.end(chunks.size() - 1) == last);
+    for (size_t i = 0; i < chunks.size(); i++) {
+        CHECK(chunks.begin(i) <= chunks.end(i));
+        if (i > 0) {
+            CHECK(chunks.begin(i) == chunks.end(i - 1));
+            CHECK(chunks.begin(i) == last || uintptr_t(chunks.begin(i)) % 64 == 0);
+        }
+    }
+}
+
+void check_algorithms(const int* first, const int* last, ThreadPool& pool)
+{
+    check_chunks(first, last, pool.size());
+    auto under18 = [](int i) { return i < 18; };
+    auto over16 = [](int i) { return i > 16; };
+    auto is_30 = [](int i) { return i == 30; };
+    CHECK(par::count(first, last, 21, pool) == count(first, last, 21));
+    CHECK(par::count_if(first, last, under18, pool) == count_if(first, last, under18));
+    CHECK(par::count_if(first, last, pred::x < 18, pool) == count_if(first, last, under18));
+    CHECK(par::find(first, last, 21, pool) == find(first, last, 21));
+    CHECK(par::find(first, last, 99, pool) == last);
+    CHECK(par::find_if(first, last, is_30, pool) == find_if(first, last, is_30));
+    CHECK(par::all_of(first, last, over16, pool) == all_of(first, last, over16));
+    CHECK(par::none_of(first, last, under18, pool) == none_of(first, last, under18));
+    CHECK(par::any_of(first, last, is_30, pool) == any_of(first, last, is_30));
+}
+
+void check_erase(vector<int> v, ThreadPool& pool)
+{
+    vector<int> expected = v;
+    auto is_even = [](int i) { return i % 2 == 0; };
+    expected.erase(remove_if(expected.begin(), expected.end(), is_even), expected.end());
+    size_t evens = size_t(count_if(v.begin(), v.end(), is_even));
+    CHECK(par::erase_matching(v, is_even, pool) == evens);
+    CHECK(v == expected);
+}
+
+int main()
+{
+    mt19937 gen(206);
+    uniform_int_distribution<int> age(16, 29);      // 30 only where a test puts it
+    const ptrdiff_t MIN = par::MIN_PARALLEL;
+
+    ThreadPool one(1), two(2), four(4);
+    for (ThreadPool* pool : {&one, &two, &four, &ThreadPool::shared()}) {
+        for (ptrdiff_t n : {ptrdiff_t(0), ptrdiff_t(100), MIN - 1, MIN, 3 * MIN + 13, 20 * MIN}) {
+            vector<int> v(n + 8);
+            for (int& a : v)
+                a = age(gen);
+            // also start off a cache-line boundary
+            for (int skew : {0, 1, 3}) {
+                const int* first = v.data() + skew;
+                check_algorithms(first, first + n, *pool);
+            }
+
+            // find_if must return the FIRST match, even when every chunk has
+            // one and the later chunks are searched at the same time
+            if (n > 0) {
+                for (ptrdiff_t i = n - 1; i >= 0; i -= max<ptrdiff_t>(1, n / 37))
+                    v[i] = 30;
+                check_algorithms(v.data(), v.data() + n, *pool);
+            }
+            v.resize(n);
+            check_erase(v, *pool);
+        }
+
+        // the iterator versions
+        vector<int> v(2 * MIN, 17);
+        v[MIN + 5] = 30;
+        CHECK(par::find(v.begin(), v.end(), 30, *pool) == v.begin() + MIN + 5);
+        CHECK(par::count(v.cbegin(), v.cend(), 17, *pool) == 2 * MIN - 1);
+        CHECK(par::all_of(v.begin(), v.end(), pred::x >= 17, *pool));
+    }
+
+    // Cancellation: with one thread the chunks run in order, so once chunk 0
+    // finds a match every later chunk must stop before reading anything.
+    vector<int> v(20 * MIN, 17);
+    v[10] = 30;
+    atomic<long> calls(0);
+    auto counted = [&](int i) {
+        calls.fetch_add(1, memory_order_relaxed);
+        return i == 30;
+    };
+    CHECK(par::find_if(v.data(), v.data() + v.size(), counted, one) == v.data() + 10);
+    CHECK(calls.load() == 11);
+
+    // with several threads the chunks race, but the earliest match still wins
+    v[10] = 17;
+    v[3 * MIN] = 30;
+    v[15 * MIN] = 30;
+    for (int run = 0; run < 20; run++)
+        CHECK(par::find_if(v.data(), v.data() + v.size(), counted, four) == v.data() + 3 * MIN);
+
+    return check_report();
+}
@@ -0,0 +1,124 @@
+// predicate_test - pred:: expressions must give the same answers as lambdas, and
+// range_of() must give the interval each one accepts
+
+#include <algorithm>
+#include <climits>
+#include <optional>
+#include <random>
+#include <vector>
+#include "../predicate.h"
+#include "check.h"
+using namespace std;
+using pred::x;
+
+// values at and around every constant used below
+const vector<int> edges = {INT_MIN, INT_MIN + 1, -1, 0, 1, 15, 16, 17, 18, 19, 20, 21, 22,
+                           25, 26, 29, 30, 31, 59, 60, 61, INT_MAX - 1, INT_MAX};
+
+bool same_range(optional<pred::Range> r, int lo, int hi, bool outside)
+{
+    return r && r->lo == lo && r->hi == hi && r->outside == outside;
+}
+
+bool empty_range(optional<pred::Range> r)
+{
+    return r && !r->outside && r->lo > r->hi;
+}
+
+// range_of(p) accepts exactly the values p accepts
+template <typename P>
+void check_range(const pred::Expr<P>& e)
+{
+    optional<pred::Range> r = pred::range_of(e.self());
+    CHECK(r.has_value());
+    if (r) {
+        for (int v : edges)
+            CHECK(r->contains(v) == e.self()(v));
+    }
+}
+
+void check_range_of()
+{
+    CHECK(same_range(pred::range_of(x < 18), INT_MIN, 17, false));
+    CHECK(same_range(pred::range_of(x <= 18), INT_MIN, 18, false));
+    CHECK(same_range(pred::range_of(x > 16), 17, INT_MAX, false));
+    CHECK(same_range(pred::range_of(x >= 16), 16, INT_MAX, false));
+    CHECK(same_range(pred::range_of(x == 21), 21, 21, false));
+    CHECK(same_range(pred::range_of(x != 21), 21, 21, true));
+    CHECK(same_range(pred::range_of(pred::between(17, 21)), 17, 21, false));
+
+    // the ends of int: nothing is below INT_MIN or above INT_MAX
+    CHECK(empty_range(pred::range_of(x < INT_MIN)));
+    CHECK(empty_range(pred::range_of(x > INT_MAX)));
+    CHECK(same_range(pred::range_of(x <= INT_MAX), INT_MIN, INT_MAX, false));
+    CHECK(same_range(pred::range_of(x > INT_MIN), INT_MIN + 1, INT_MAX, false));
+
+    // between with lo > hi wraps around, like its unsigned comparison
+    CHECK(same_range(pred::range_of(pred::between(30, 16)), 17, 29, true));
+    CHECK(same_range(pred::range_of(pred::between(INT_MAX, INT_MIN)), INT_MIN + 1, INT_MAX - 1, true));
+    CHECK(same_range(pred::range_of(pred::between(1, 0)), 1, 0, true));     // everything
+
+    CHECK(same_range(pred::range_of(!(x < 18)), INT_MIN, 17, true));
+    CHECK(same_range(pred::range_of(!!(x < 18)), INT_MIN, 17, false));
+    CHECK(same_range(pred::range_of(x > 16 && x < 30), 17, 29, false));
+    CHECK(same_range(pred::range_of(pred::between(16, 25) && pred::between(20, 60)), 20, 25, false));
+    CHECK(empty_range(pred::range_of(x > 30 && x < 16)));
+    CHECK(same_range(pred::range_of(x != 21 || !pred::between(18, 25)), 21, 21, true));
+    CHECK(same_range(pred::range_of(!(x > 16 && x < 30)), 17, 29, true));
+
+    // && of an outside range and || of an inside one are not one interval
+    CHECK(!pred::range_of(x > 16 && x != 21));
+    CHECK(!pred::range_of(x < 18 || x > 25));
+    CHECK(!pred::range_of(x != 21 || x < 18));
+    CHECK(!pred::range_of(!(x >= 20 && x <= 25) || x < INT_MIN));     // though it is outside 20..25
+    CHECK(!pred::has_range<pred::ModEqual<2>>);
+    CHECK(!pred::has_range<decltype(x < 18 && pred::mod<2> == 0)>);
+
+    check_range(x < 18);
+    check_range(x < INT_MIN);
+    check_range(x > INT_MAX);
+    check_range(x >= INT_MIN);
+    check_range(pred::between(30, 16));
+    check_range(pred::between(INT_MAX, INT_MIN));
+    check_range(!pred::between(17, 21));
+    check_range(x > 16 && x < 30);
+    check_range(x > 30 && x < 16);
+    check_range(x != 21 || x != 22);
+    check_range(!pred::between(16, 30) || !pred::between(20, 60));
+    check_range(!(x >= 20 && x <= 25) || x != 22);
+}
+
+// the kernels against <algorithm> with the same predicate as a lambda
+template <typename P, typename F>
+void check_kernels(const vector<int>& v, const pred::Expr<P>& e, F f)
+{
+    CHECK(pred::count_if(v.begin(), v.end(), e) == count_if(v.begin(), v.end(), f));
+    CHECK(pred::find_if(v.begin(), v.end(), e) == find_if(v.begin(), v.end(), f));
+    CHECK(pred::all_of(v.begin(), v.end(), e) == all_of(v.begin(), v.end(), f));
+    CHECK(pred::any_of(v.begin(), v.end(), e) == any_of(v.begin(), v.end(), f));
+    CHECK(pred::none_of(v.begin(), v.end(), e) == none_of(v.begin(), v.end(), f));
+}
+
+int main()
+{
+    check_range_of();
+
+    mt19937 gen(206);
+    uniform_int_distribution<int> age(16, 30);
+    for (size_t n : {size_t(0), size_t(1), size_t(pred::BLOCK - 1), size_t(pred::BLOCK),
+                     size_t(5 * pred::BLOCK + 3)}) {
+        vector<int> v(n);
+        for (int& a : v)
+            a = age(gen);
+        if (n > 0)
+            v[n - 1] = -3;      // the only negative age, in the last block
+        check_kernels(v, x < 18, [](int i) { return i < 18; });
+        check_kernels(v, x > 16 && x < 30, [](int i) { return i > 16 && i < 30; });
+        check_kernels(v, pred::between(30, 16), [](int i) { return i <= 16 || i >= 30; });
+        check_kernels(v, x < 0, [](int i) { return i < 0; });
+        check_kernels(v, pred::mod<2> == 0, [](int i) { return i % 2 == 0; });
+        check_kernels(v, pred::mod<3> == 0 || x == 21, [](int i) { return i % 3 == 0 || i == 21; });
+    }
+
+    return check_report();
+}
@@ -0,0 +1,63 @@
+// query_batch_test - query::scan() must give the same answers as <algorithm>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "../query_batch.h"
+#include "check.h"
+using namespace std;
+
+ptrdiff_t index_of(const vector<int>& v, vector<int>::const_iterator it)
+{
+    return it == v.end() ? query::not_found : it - v.begin();
+}
+
+void check_queries(const vector<int>& v)
+{
+    auto [n21, under18, all_over16, none_over40, any_30, at_21, first_even] =
+        query::scan(v,
+                    query::count(21),
+                    query::count_if(pred::x < 18),
+                    query::all_of(pred::x > 16),
+                    query::none_of(pred::x > 40),
+                    query::any_of(pred::x == 30),
+                    query::find(21),
+                    query::find_if(pred::mod<2> == 0));
+
+    CHECK(n21 == count(v.begin(), v.end(), 21));
+    CHECK(under18 == count_if(v.begin(), v.end(), [](int i) { return i < 18; }));
+    CHECK(all_over16 == all_of(v.begin(), v.end(), [](int i) { return i > 16; }));
+    CHECK(none_over40 == none_of(v.begin(), v.end(), [](int i) { return i > 40; }));
+    CHECK(any_30 == any_of(v.begin(), v.end(), [](int i) { return i == 30; }));
+    CHECK(at_21 == index_of(v, find(v.begin(), v.end(), 21)));
+    CHECK(first_even == index_of(v, find_if(v.begin(), v.end(), [](int i) { return i % 2 == 0; })));
+
+    // only short-circuiting queries - the scan may stop early
+    auto [found, none_under0] = query::scan(v, query::find(30), query::none_of(pred::x < 0));
+    CHECK(found == index_of(v, find(v.begin(), v.end(), 30)));
+    CHECK(none_under0 == none_of(v.begin(), v.end(), [](int i) { return i < 0; }));
+}
+
+int main()
+{
+    mt19937 gen(206);
+    uniform_int_distribution<int> age(16, 30);
+    const ptrdiff_t B = query::BLOCK;
+
+    for (ptrdiff_t n : {ptrdiff_t(0), ptrdiff_t(1), ptrdiff_t(5), B - 1, B, B + 1, 3 * B + 7}) {
+        vector<int> v(n);
+        for (int& a : v)
+            a = age(gen);
+        check_queries(v);
+
+        // one match, placed in the last block - early blocks must not settle the finds
+        vector<int> w(n, 17);
+        if (n > 0) {
+            w[n - 1] = 30;
+            if (n > 1)
+                w[n - 2] = 21;
+        }
+        check_queries(w);
+    }
+    return check_report();
+}
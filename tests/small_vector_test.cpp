@@ -0,0 +1,185 @@
+// small_vector_test - SmallVector must behave like vector, inline and on the heap,
+// and must neither leak nor lose elements when copying an element throws
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../small_vector.h"
+#include "check.h"
+using namespace std;
+
+// An element whose copies start to throw after "copies_left" of them.  Its
+// move may throw too (it is not noexcept), so SmallVector must copy it when
+// it grows.  "alive" counts the objects that exist, to find leaks and
+// double destruction.
+struct Fragile {
+    static inline int copies_left = 1 << 30;
+    static inline int alive = 0;
+
+    string value;
+
+    explicit Fragile(string v) : value(std::move(v)) { alive++; }
+    Fragile(const Fragile& other) : value(other.value)
+    {
+        if (copies_left-- <= 0)
+            throw runtime_error("copy failed");
+        alive++;
+    }
+    Fragile(Fragile&& other) : value(std::move(other.value)) { alive++; }
+    Fragile& operator=(const Fragile&) = default;
+    Fragile& operator=(Fragile&&) = default;
+    ~Fragile() { alive--; }
+};
+
+// The same for a move that throws, on an element that cannot be copied - the
+// elements must be moved, and if that fails only the new block is freed
+struct FragileMoveOnly {
+    static inline int moves_left = 1 << 30;
+    static inline int alive = 0;
+
+    int value;
+
+    explicit FragileMoveOnly(int v) : value(v) { alive++; }
+    FragileMoveOnly(const FragileMoveOnly&) = delete;
+    FragileMoveOnly(FragileMoveOnly&& other) : value(other.value)
+    {
+        if (moves_left-- <= 0)
+            throw runtime_error("move failed");
+        alive++;
+    }
+    ~FragileMoveOnly() { alive--; }
+};
+
+template <size_t N>
+bool same(const SmallVector<int, N>& small, const vector<int>& v)
+{
+    return small.size() == v.size() && equal(small.begin(), small.end(), v.begin(), v.end());
+}
+
+void check_like_vector()
+{
+    mt19937 gen(206);
+    SmallVector<int, 6> small;
+    vector<int> v;
+    for (int i = 0; i < 6; i++) {
+        small.push_back(i);
+        v.push_back(i);
+    }
+    CHECK(small.is_inline() && same(small, v));
+    small.push_back(6);      // the seventh element moves everything to the heap
+    v.push_back(6);
+    CHECK(!small.is_inline() && same(small, v));
+
+    for (int step = 0; step < 2000; step++) {
+        size_t at = v.empty() ? 0 : gen() % v.size();
+        switch (gen() % 4) {
+        case 0:
+            small.insert(small.begin() + at, step);
+            v.insert(v.begin() + ptrdiff_t(at), step);
+            break;
+        case 1:
+            small.push_back(small.empty() ? step : small[0]);     // an element of itself
+            v.push_back(v.empty() ? step : v[0]);
+            break;
+        case 2:
+            if (!v.empty()) {
+                small.erase(small.begin() + at);
+                v.erase(v.begin() + ptrdiff_t(at));
+            }
+            break;
+        default:
+            if (!v.empty()) {
+                small.pop_back();
+                v.pop_back();
+            }
+        }
+    }
+    CHECK(same(small, v));
+
+    SmallVector<int, 6> copy = small;
+    CHECK(copy == small);
+    SmallVector<int, 6> moved = std::move(copy);
+    CHECK(moved == small);
+    SmallVector<int, 6> lotto = {2, 10, 13, 22, 35, 47};
+    CHECK(lotto.is_inline() && (lotto < SmallVector<int, 6>{2, 10, 13, 22, 35, 48}));
+    lotto.swap(moved);
+    CHECK(lotto == small && moved.size() == 6);
+
+    bool threw = false;
+    try {
+        lotto.at(lotto.size());
+    } catch (const out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+// Growing with a copy that throws leaves the SmallVector as it was
+void check_growth_throws()
+{
+    {
+        SmallVector<Fragile, 2> small;
+        small.emplace_back("a");
+        small.emplace_back("b");
+        int before = Fragile::alive;
+
+        Fragile::copies_left = 1;       // the first element copies, the second throws
+        bool threw = false;
+        try {
+            small.emplace_back("c");
+        } catch (const runtime_error&) {
+            threw = true;
+        }
+        Fragile::copies_left = 1 << 30;
+        CHECK(threw);
+        CHECK(Fragile::alive == before);
+        CHECK(small.is_inline() && small.size() == 2);
+        CHECK(small[0].value == "a" && small[1].value == "b");
+
+        // and it still grows once copying works again
+        for (string s : {"c", "d", "e", "f", "g"})
+            small.emplace_back(s);
+        CHECK(small.size() == 7 && small[6].value == "g");
+
+        // the same from a heap block to a bigger one
+        Fragile::copies_left = 3;
+        threw = false;
+        try {
+            small.reserve(100);
+        } catch (const runtime_error&) {
+            threw = true;
+        }
+        Fragile::copies_left = 1 << 30;
+        CHECK(threw);
+        CHECK(small.size() == 7 && small[0].value == "a" && small[6].value == "g");
+    }
+    CHECK(Fragile::alive == 0);
+
+    {
+        SmallVector<FragileMoveOnly, 2> small;
+        small.emplace_back(1);
+        small.emplace_back(2);
+        FragileMoveOnly::moves_left = 1;
+        bool threw = false;
+        try {
+            small.reserve(10);
+        } catch (const runtime_error&) {
+            threw = true;
+        }
+        FragileMoveOnly::moves_left = 1 << 30;
+        CHECK(threw);
+        CHECK(small.is_inline() && small.size() == 2 && small[1].value == 2);
+        small.reserve(10);
+        CHECK(!small.is_inline() && small[0].value == 1 && small[1].value == 2);
+    }
+    CHECK(FragileMoveOnly::alive == 0);
+}
+
+int main()
+{
+    check_like_vector();
+    check_growth_throws();
+    return check_report();
+}
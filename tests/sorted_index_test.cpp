@@ -0,0 +1,105 @@
+// sorted_index_test - SortedIndex and IndexedVector must give the same answers as <algorithm>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "../sorted_index.h"
+#include "check.h"
+using namespace std;
+
+// every question, for values below, between, on and above the ages
+void check_index(const SortedIndex& index, vector<int> v)
+{
+    sort(v.begin(), v.end());
+    CHECK(index.size() == v.size());
+    CHECK(index.empty() == v.empty());
+    for (size_t i = 0; i < v.size(); i++)
+        CHECK(index.nth(i) == v[i]);
+
+    int lowest = v.empty() ? 0 : v.front() - 2;
+    int highest = v.empty() ? 0 : v.back() + 2;
+    for (int x = lowest; x <= highest; x++) {
+        size_t lower = size_t(lower_bound(v.begin(), v.end(), x) - v.begin());
+        size_t upper = size_t(upper_bound(v.begin(), v.end(), x) - v.begin());
+        CHECK(index.lower_bound(x) == lower);
+        CHECK(index.upper_bound(x) == upper);
+        CHECK(index.contains(x) == binary_search(v.begin(), v.end(), x));
+        CHECK(index.count(x) == upper - lower);
+        CHECK(index.count_less(x) == lower);
+        for (int hi : {x - 1, x, x + 3}) {
+            auto inside = [&](int i) { return x <= i && i <= hi; };
+            CHECK(index.count_between(x, hi) == size_t(count_if(v.begin(), v.end(), inside)));
+        }
+    }
+}
+
+void check_indexed(const IndexedVector& indexed, const vector<int>& v)
+{
+    CHECK(indexed.vector() == v);
+    for (int x : {-1, 15, 16, 17, 18, 21, 30, 31}) {
+        CHECK(indexed.contains(x) == (find(v.begin(), v.end(), x) != v.end()));
+        CHECK(indexed.count(x) == size_t(count(v.begin(), v.end(), x)));
+        CHECK(indexed.count_less(x) == size_t(count_if(v.begin(), v.end(), [&](int i) { return i < x; })));
+        CHECK(indexed.count_between(x, x + 2) ==
+              size_t(count_if(v.begin(), v.end(), [&](int i) { return x <= i && i <= x + 2; })));
+    }
+}
+
+int main()
+{
+    mt19937 gen(206);
+
+    // every size up to a few full levels, so the last level is empty, partly
+    // filled and full, with distinct ages and with many repeats
+    for (int n = 0; n <= 300; n++) {
+        vector<int> distinct(n);
+        for (int i = 0; i < n; i++)
+            distinct[i] = 3 * i;
+        shuffle(distinct.begin(), distinct.end(), gen);
+        check_index(SortedIndex(distinct), distinct);
+
+        uniform_int_distribution<int> age(16, 30);
+        vector<int> repeats(n);
+        for (int& a : repeats)
+            a = age(gen);
+        check_index(SortedIndex(repeats), repeats);
+    }
+    vector<int> big(100'000);
+    uniform_int_distribution<int> wide(-1'000'000, 1'000'000);
+    for (int& a : big)
+        a = wide(gen);
+    SortedIndex big_index(big);
+    sort(big.begin(), big.end());
+    for (int k = 0; k < 2000; k++) {
+        int x = wide(gen);
+        CHECK(big_index.lower_bound(x) == size_t(lower_bound(big.begin(), big.end(), x) - big.begin()));
+        size_t i = gen() % big.size();
+        CHECK(big_index.nth(i) == big[i]);
+    }
+
+    // IndexedVector rebuilds its index after every kind of change
+    IndexedVector indexed = {17, 19, 16, 18, 20, 21};
+    vector<int> v = {17, 19, 16, 18, 20, 21};
+    check_indexed(indexed, v);
+    indexed.push_back(30);
+    v.push_back(30);
+    check_indexed(indexed, v);
+    indexed.set(0, 15);
+    v[0] = 15;
+    check_indexed(indexed, v);
+    for (auto it = indexed.begin(); it != indexed.end();)
+        it = (*it % 2 == 0) ? indexed.erase(it) : it + 1;
+    v.erase(remove_if(v.begin(), v.end(), [](int i) { return i % 2 == 0; }), v.end());
+    check_indexed(indexed, v);
+    indexed.erase(indexed.begin(), indexed.begin() + 2);
+    v.erase(v.begin(), v.begin() + 2);
+    check_indexed(indexed, v);
+    indexed.pop_back();
+    v.pop_back();
+    check_indexed(indexed, v);
+    indexed.clear();
+    v.clear();
+    check_indexed(indexed, v);
+
+    return check_report();
+}
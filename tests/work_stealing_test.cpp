@@ -0,0 +1,164 @@
+// work_stealing_test - the deque must hand out every task exactly once, and the
+// steal:: algorithms must give the same answers as <algorithm>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "../work_stealing.h"
+#include "check.h"
+using namespace std;
+
+// One owner pushes and pops while three thieves steal: every task must be
+// taken exactly once, whoever takes it
+void check_deque()
+{
+    constexpr int TASKS = 200'000;
+    vector<atomic<int>> runs(TASKS);
+    vector<int> ids(TASKS);
+    for (int i = 0; i < TASKS; i++)
+        ids[i] = i;
+
+    WorkDeque<int> deque(4);        // small, so it has to grow while thieves read it
+    atomic<bool> owner_done(false);
+    vector<thread> thieves;
+    for (int t = 0; t < 3; t++) {
+        thieves.emplace_back([&] {
+            while (true) {
+                bool finished = owner_done.load();      // read before the last steal attempt
+                if (int* id = deque.steal())
+                    runs[*id]++;
+                else if (finished)
+                    return;
+            }
+        });
+    }
+    mt19937 gen(206);
+    for (int i = 0; i < TASKS; i++) {
+        deque.push(&ids[i]);
+        if (gen() % 3 == 0) {
+            if (int* id = deque.pop())
+                runs[*id]++;
+        }
+    }
+    while (int* id = deque.pop())
+        runs[*id]++;
+    owner_done = true;
+    for (thread& t : thieves)
+        t.join();
+    CHECK(deque.pop() == nullptr && deque.steal() == nullptr);
+    CHECK(all_of(runs.begin(), runs.end(), [](const atomic<int>& r) { return r.load() == 1; }));
+}
+
+void check_algorithms(const int* first, const int* last, WorkStealingScheduler& s)
+{
+    auto under18 = [](int i) { return i < 18; };
+    auto over16 = [](int i) { return i > 16; };
+    auto is_30 = [](int i) { return i == 30; };
+    CHECK(steal::count(first, last, 21, s) == count(first, last, 21));
+    CHECK(steal::count_if(first, last, under18, s) == count_if(first, last, under18));
+    CHECK(steal::find(first, last, 21, s) == find(first, last, 21));
+    CHECK(steal::find(first, last, 99, s) == last);
+    CHECK(steal::find_if(first, last, is_30, s) == find_if(first, last, is_30));
+    CHECK(steal::all_of(first, last, over16, s) == all_of(first, last, over16));
+    CHECK(steal::none_of(first, last, under18, s) == none_of(first, last, under18));
+    CHECK(steal::any_of(first, last, is_30, s) == any_of(first, last, is_30));
+}
+
+// A task that throws, at any depth of the forks, reaches the caller of run()
+void check_exceptions(WorkStealingScheduler& s)
+{
+    vector<int> v(20 * steal::GRAIN, 18);
+    for (ptrdiff_t bad : {ptrdiff_t(0), ptrdiff_t(v.size() / 2 + 7), ptrdiff_t(v.size() - 1)}) {
+        bool threw = false;
+        try {
+            steal::count_if(v.data(), v.data() + v.size(), [&](const int& i) {
+                if (&i - v.data() == bad)
+                    throw runtime_error("bad age");
+                return i < 18;
+            }, s);
+        } catch (const runtime_error&) {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+    bool threw = false;
+    try {
+        s.run([&] { s.fork_join([] {}, [] { throw logic_error("right half"); }); });
+    } catch (const logic_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    // and the scheduler still works afterwards
+    CHECK(steal::count(v.data(), v.data() + v.size(), 18, s) == ptrdiff_t(v.size()));
+}
+
+// Threads that ran the leaves of one parallel_reduce, with leaves slow
+// enough that the idle threads always find something to steal
+size_t threads_used(WorkStealingScheduler& s)
+{
+    vector<int> v(64);
+    mutex m;
+    set<thread::id> seen;
+    parallel_reduce(s, v.data(), v.data() + v.size(), 1,
+        [&](const int*, const int*) {
+            this_thread::sleep_for(chrono::milliseconds(2));
+            lock_guard<mutex> lock(m);
+            seen.insert(this_thread::get_id());
+            return 0;
+        },
+        [](int a, int b) { return a + b; });
+    return seen.size();
+}
+
+// A task of scheduler a that calls b.run() must still fork on a afterwards
+void check_nested_run()
+{
+    WorkStealingScheduler a(4), b(2);
+    size_t before = 0, after = 0;
+    a.run([&] {
+        before = threads_used(a);
+        vector<int> v(4 * steal::GRAIN, 17);
+        CHECK(steal::count(v.data(), v.data() + v.size(), 17, b) == ptrdiff_t(v.size()));
+        after = threads_used(a);
+    });
+    CHECK(before > 1);
+    CHECK(after > 1);
+}
+
+int main()
+{
+    check_deque();
+
+    mt19937 gen(206);
+    uniform_int_distribution<int> age(16, 29);      // 30 only where a test puts it
+    const ptrdiff_t G = steal::GRAIN;
+    for (unsigned threads : {1u, 2u, 4u}) {
+        WorkStealingScheduler s(threads);
+        for (ptrdiff_t n : {ptrdiff_t(0), ptrdiff_t(1), G - 1, G, G + 1, 37 * G + 5}) {
+            vector<int> v(n);
+            for (int& a : v)
+                a = age(gen);
+            check_algorithms(v.data(), v.data() + n, s);
+
+            // a match in every piece - find must still return the first one
+            if (n > 0) {
+                for (ptrdiff_t i = n - 1; i >= 0; i -= max<ptrdiff_t>(1, G / 3))
+                    v[i] = 30;
+                for (int run = 0; run < 5; run++)
+                    check_algorithms(v.data(), v.data() + n, s);
+                v[0] = 30;
+                CHECK(steal::find(v.data(), v.data() + n, 30, s) == v.data());
+            }
+        }
+        check_exceptions(s);
+    }
+    check_nested_run();
+
+    return check_report();
+}
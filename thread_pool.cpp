@@ -0,0 +1,115 @@
+// thread_pool - a fixed set of worker threads that run parallel loops
+
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace {
+// true while this thread is running a task - a nested run() then runs inline
+thread_local bool inside_task = false;
+}
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = 1;
+    workers.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; i++)
+        workers.emplace_back([this] { worker_loop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (thread& worker : workers)
+        worker.join();
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::run(size_t n, const function<void(size_t)>& fn)
+{
+    if (n == 0)
+        return;
+    if (inside_task || workers.empty() || n == 1) {
+        for (size_t i = 0; i < n; i++)
+            fn(i);
+        return;
+    }
+
+    lock_guard<std::mutex> one_loop_at_a_time(run_mutex);
+    {
+        lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        task_count = n;
+        next_task = 0;
+        finished_tasks = 0;
+        error = nullptr;
+        ++generation;
+    }
+    work_ready.notify_all();
+
+    run_tasks();    // the calling thread works too, rather than just waiting
+
+    exception_ptr failure;
+    {
+        unique_lock<std::mutex> lock(mutex);
+        work_done.wait(lock, [this] { return finished_tasks == task_count; });
+        task = nullptr;
+        failure = error;
+    }
+    if (failure)
+        rethrow_exception(failure);
+}
+
+void ThreadPool::run_tasks()
+{
+    while (true) {
+        const function<void(size_t)>* fn;
+        size_t i;
+        {
+            lock_guard<std::mutex> lock(mutex);
+            if (task == nullptr || next_task == task_count)
+                return;
+            fn = task;
+            i = next_task++;
+        }
+
+        inside_task = true;
+        try {
+            (*fn)(i);
+        } catch (...) {
+            lock_guard<std::mutex> lock(mutex);
+            if (!error)
+                error = current_exception();
+        }
+        inside_task = false;
+
+        lock_guard<std::mutex> lock(mutex);
+        if (++finished_tasks == task_count)
+            work_done.notify_one();
+    }
+}
+
+void ThreadPool::worker_loop()
+{
+    unsigned long seen = 0;
+    while (true) {
+        {
+            unique_lock<std::mutex> lock(mutex);
+            work_ready.wait(lock, [&] { return stopping || (task != nullptr && generation != seen); });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+        run_tasks();
+    }
+}
@@ -0,0 +1,67 @@
+// thread_pool - a fixed set of worker threads that run parallel loops
+//
+// https://en.cppreference.com/w/cpp/thread/thread
+
+#ifndef SAM206_THREAD_POOL_H
+#define SAM206_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ *  ThreadPool
+ *  Starting a thread is expensive, so the pool starts its worker threads
+ *  once, and they then wait for work.  run(n, task) calls task(0) ...
+ *  task(n-1), shared out between the workers and the calling thread, and
+ *  returns when all of the calls have finished:
+ *
+ *      ThreadPool& pool = ThreadPool::shared();
+ *      pool.run(chunks, [&](size_t i) { partial[i] = count_chunk(i); });
+ *
+ *  If a task throws, the first exception is passed on by run().
+ *  A task may itself call run() - the inner loop is then run by the
+ *  calling thread alone, so the pool can never deadlock waiting on itself.
+ */
+class ThreadPool {
+public:
+    // threads = total number of threads that run tasks, including the caller
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return unsigned(workers.size()) + 1; }
+
+    void run(std::size_t n, const std::function<void(std::size_t)>& task);
+
+    // One pool for the whole program, sized to the number of CPU cores
+    static ThreadPool& shared();
+
+private:
+    void worker_loop();
+    void run_tasks();   // takes task numbers until there are none left
+
+    std::vector<std::thread> workers;
+
+    std::mutex run_mutex;           // only one run() at a time uses the workers
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+
+    // the current parallel loop - protected by "mutex"
+    const std::function<void(std::size_t)>* task = nullptr;
+    std::size_t task_count = 0;
+    std::size_t next_task = 0;
+    std::size_t finished_tasks = 0;
+    unsigned long generation = 0;   // changes each time run() starts a loop
+    std::exception_ptr error;
+    bool stopping = false;
+};
+
+#endif //SAM206_THREAD_POOL_H
@@ -0,0 +1,142 @@
+// work_stealing - a fork/join scheduler with per-thread work-stealing deques
+
+#include "work_stealing.h"
+
+using namespace std;
+
+namespace {
+// which scheduler (if any) the current thread works for, and its deque number
+thread_local WorkStealingScheduler* tls_scheduler = nullptr;
+thread_local unsigned tls_index = 0;
+
+// xorshift - a cheap random number to choose which thread to steal from
+uint64_t next_random(uint64_t& seed)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+
+void pause_briefly(unsigned& failures)
+{
+    if (++failures < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    } else {
+        this_thread::yield();   // let the thread that has the work run
+    }
+}
+}
+
+WorkStealingScheduler::WorkStealingScheduler(unsigned threads)
+{
+    if (threads == 0)
+        threads = 1;
+    for (unsigned i = 0; i < threads; i++)
+        deques.push_back(make_unique<WorkDeque<Task>>());
+    workers.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; i++)
+        workers.emplace_back([this, i] { worker_loop(i); });
+}
+
+WorkStealingScheduler::~WorkStealingScheduler()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread& worker : workers)
+        worker.join();
+}
+
+WorkStealingScheduler& WorkStealingScheduler::shared()
+{
+    static WorkStealingScheduler scheduler;
+    return scheduler;
+}
+
+WorkStealingScheduler* WorkStealingScheduler::current_scheduler()
+{
+    return tls_scheduler;
+}
+
+unsigned WorkStealingScheduler::current_index()
+{
+    return tls_index;
+}
+
+WorkStealingScheduler::Session::Session(WorkStealingScheduler& s)
+    : s(s), previous_scheduler(tls_scheduler), previous_index(tls_index)
+{
+    tls_scheduler = &s;
+    tls_index = 0;
+    {
+        lock_guard<std::mutex> lock(s.mutex);
+        s.active.store(true, memory_order_release);
+    }
+    s.wake.notify_all();
+}
+
+WorkStealingScheduler::Session::~Session()
+{
+    s.active.store(false, memory_order_release);
+    tls_scheduler = previous_scheduler;
+    tls_index = previous_index;
+}
+
+void WorkStealingScheduler::worker_loop(unsigned index)
+{
+    tls_scheduler = this;
+    tls_index = index;
+    uint64_t seed = 0x9E3779B97F4A7C15ull * (index + 1);
+
+    while (true) {
+        {
+            unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || active.load(memory_order_acquire); });
+            if (stopping)
+                return;
+        }
+        // steal until the current run() finishes, then go back to sleep
+        unsigned failures = 0;
+        while (active.load(memory_order_acquire)) {
+            if (try_steal_and_execute(index, seed))
+                failures = 0;
+            else
+                pause_briefly(failures);
+        }
+    }
+}
+
+bool WorkStealingScheduler::try_steal_and_execute(unsigned thief, uint64_t& seed)
+{
+    unsigned n = size();
+    if (n < 2)
+        return false;
+    unsigned start = unsigned(next_random(seed) % n);
+    for (unsigned k = 0; k < n; k++) {
+        unsigned victim = (start + k) % n;
+        if (victim == thief)
+            continue;
+        if (Task* task = deques[victim]->steal()) {
+            task->execute();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingScheduler::help_until_done(const Task& task)
+{
+    uint64_t seed = reinterpret_cast<uintptr_t>(&task) | 1;
+    unsigned failures = 0;
+    while (!task.done.load(memory_order_acquire)) {
+        if (try_steal_and_execute(current_index(), seed))
+            failures = 0;
+        else
+            pause_briefly(failures);
+    }
+}
@@ -0,0 +1,372 @@
+// work_stealing - a fork/join scheduler with per-thread work-stealing deques
+//
+// https://en.wikipedia.org/wiki/Work_stealing
+
+#ifndef SAM206_WORK_STEALING_H
+#define SAM206_WORK_STEALING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ *  WorkDeque
+ *  The lock-free double-ended queue of Chase and Lev.  One thread - the
+ *  owner - pushes and pops tasks at the bottom, like a stack.  Any other
+ *  thread may steal the oldest task from the top.  The owner and the
+ *  thieves only have to agree (with a compare-and-swap) when they go for
+ *  the last task.  The array doubles in size when it is full; old arrays
+ *  are kept until the deque is destroyed, because a thief may still be
+ *  reading one.
+ */
+template <typename T>
+class WorkDeque {
+public:
+    explicit WorkDeque(std::size_t capacity = 256)
+    {
+        arrays.push_back(std::make_unique<Array>(capacity));
+        array.store(arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkDeque(const WorkDeque&) = delete;
+    WorkDeque& operator=(const WorkDeque&) = delete;
+
+    // owner only
+    void push(T* item)
+    {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        Array* a = array.load(std::memory_order_relaxed);
+        if (b - t > std::int64_t(a->size) - 1)
+            a = grow(a, t, b);
+        a->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner only - returns nullptr when empty
+    T* pop()
+    {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+
+        T* item = nullptr;
+        if (t <= b) {
+            item = a->get(b);
+            if (t == b) {
+                // last task - a thief may be taking it at the same moment
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                 std::memory_order_relaxed))
+                    item = nullptr;
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // any thread - returns nullptr when empty, or when another thread won the race
+    T* steal()
+    {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+        Array* a = array.load(std::memory_order_acquire);
+        T* item = a->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
+            return nullptr;
+        return item;
+    }
+
+private:
+    struct Array {
+        explicit Array(std::size_t size) : size(size), mask(size - 1), slots(new std::atomic<T*>[size]) {}
+        T* get(std::int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(std::int64_t i, T* item) { slots[i & mask].store(item, std::memory_order_relaxed); }
+
+        std::size_t size;       // always a power of 2
+        std::size_t mask;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+    };
+
+    Array* grow(Array* old, std::int64_t t, std::int64_t b)
+    {
+        arrays.push_back(std::make_unique<Array>(old->size * 2));
+        Array* bigger = arrays.back().get();
+        for (std::int64_t i = t; i < b; i++)
+            bigger->put(i, old->get(i));
+        array.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top{0};
+    alignas(64) std::atomic<std::int64_t> bottom{0};
+    std::atomic<Array*> array;
+    std::vector<std::unique_ptr<Array>> arrays;     // owner only
+};
+
+/**
+ *  WorkStealingScheduler
+ *  Every thread has its own WorkDeque.  fork_join(a, b) pushes b on the
+ *  calling thread's deque and runs a.  Meanwhile an idle thread may steal b
+ *  and run it.  If nobody stole it, the caller pops b and runs it itself,
+ *  so an unused fork costs only a push and a pop.  If b was stolen, the
+ *  caller steals other work while it waits for b to finish.
+ *
+ *  Because each range is split in half again and again, a thread that was
+ *  slowed down (an expensive part of the data, or the operating system
+ *  running something else) simply has its remaining halves stolen -
+ *  unlike a fixed split, where the other threads would sit idle.
+ *
+ *      WorkStealingScheduler& s = WorkStealingScheduler::shared();
+ *      s.run([&] { s.fork_join([&] { left(); }, [&] { right(); }); });
+ *
+ *  fork_join() called outside run() just calls a() then b().
+ *  Exceptions thrown by a or b are passed on by fork_join() and run().
+ */
+class WorkStealingScheduler {
+public:
+    // threads = total number of threads, including the one that calls run()
+    explicit WorkStealingScheduler(unsigned threads = std::thread::hardware_concurrency());
+    ~WorkStealingScheduler();
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    unsigned size() const { return unsigned(deques.size()); }
+
+    // Runs root() on the calling thread, with all of the threads available
+    // to steal the work it forks.  Returns when root() has returned.
+    template <typename F>
+    void run(F&& root)
+    {
+        if (current_scheduler() == this) {     // already inside run()
+            root();
+            return;
+        }
+        std::lock_guard<std::mutex> one_root_at_a_time(run_mutex);
+        Session session(*this);
+        root();
+    }
+
+    template <typename A, typename B>
+    void fork_join(A&& a, B&& b)
+    {
+        if (current_scheduler() != this) {
+            a();
+            b();
+            return;
+        }
+        WorkDeque<Task>& own = *deques[current_index()];
+        CallTask<std::remove_reference_t<B>> task_b(b);
+        own.push(&task_b);
+
+        std::exception_ptr a_failed;
+        try {
+            a();
+        } catch (...) {
+            a_failed = std::current_exception();
+        }
+
+        if (own.pop() == &task_b)
+            task_b.execute();           // nobody stole it - run it here
+        else
+            help_until_done(task_b);    // it was stolen - work on other tasks meanwhile
+
+        if (a_failed)
+            std::rethrow_exception(a_failed);
+        if (task_b.failed)
+            std::rethrow_exception(task_b.failed);
+    }
+
+    static WorkStealingScheduler& shared();
+
+private:
+    struct Task {
+        virtual void run() = 0;
+        void execute()
+        {
+            try {
+                run();
+            } catch (...) {
+                failed = std::current_exception();
+            }
+            done.store(true, std::memory_order_release);
+        }
+        std::atomic<bool> done{false};
+        std::exception_ptr failed;
+    protected:
+        ~Task() = default;
+    };
+
+    template <typename F>
+    struct CallTask final : Task {
+        explicit CallTask(F& f) : f(f) {}
+        void run() override { f(); }
+        F& f;
+    };
+
+    // Marks the calling thread as thread 0 and wakes the workers for one run().
+    // A task of another scheduler may call run(), so the thread's previous
+    // scheduler and deque number are put back afterwards.
+    struct Session {
+        explicit Session(WorkStealingScheduler& s);
+        ~Session();
+        WorkStealingScheduler& s;
+        WorkStealingScheduler* previous_scheduler;
+        unsigned previous_index;
+    };
+
+    static WorkStealingScheduler* current_scheduler();
+    static unsigned current_index();
+
+    void worker_loop(unsigned index);
+    bool try_steal_and_execute(unsigned thief, std::uint64_t& seed);
+    void help_until_done(const Task& task);
+
+    std::vector<std::unique_ptr<WorkDeque<Task>>> deques;   // one per thread, [0] = caller of run()
+    std::vector<std::thread> workers;
+
+    std::mutex run_mutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::atomic<bool> active{false};   // true while a run() is in progress
+    bool stopping = false;
+};
+
+/**
+ * Splits [first, last) in halves until they hold at most "grain" elements,
+ * calls leaf(b, e) on each piece, and combines the results with combine().
+ */
+template <typename Leaf, typename Combine>
+auto parallel_reduce(WorkStealingScheduler& s, const int* first, const int* last,
+                     std::ptrdiff_t grain, Leaf leaf, Combine combine)
+{
+    if (last - first <= grain)
+        return leaf(first, last);
+    const int* mid = first + (last - first) / 2;
+    decltype(leaf(first, last)) left{}, right{};
+    s.fork_join([&] { left = parallel_reduce(s, first, mid, grain, leaf, combine); },
+                [&] { right = parallel_reduce(s, mid, last, grain, leaf, combine); });
+    return combine(left, right);
+}
+
+/**
+ *  Work-stealing versions of the algorithms in parallel.h.  The range is
+ *  split recursively into pieces of GRAIN elements, so a piece with
+ *  expensive elements is shared out instead of holding up one thread.
+ */
+namespace steal {
+
+constexpr std::ptrdiff_t GRAIN = 1 << 14;
+
+template <typename Pred>
+std::ptrdiff_t count_if(const int* first, const int* last, Pred pred,
+                        WorkStealingScheduler& s = WorkStealingScheduler::shared())
+{
+    std::ptrdiff_t n = 0;
+    s.run([&] {
+        n = parallel_reduce(s, first, last, GRAIN,
+            [&](const int* b, const int* e) {
+                std::ptrdiff_t c = 0;
+                for (; b != e; ++b)
+                    c += bool(pred(*b));
+                return c;
+            },
+            [](std::ptrdiff_t x, std::ptrdiff_t y) { return x + y; });
+    });
+    return n;
+}
+
+inline std::ptrdiff_t count(const int* first, const int* last, int value,
+                            WorkStealingScheduler& s = WorkStealingScheduler::shared())
+{
+    return steal::count_if(first, last, [value](int v) { return v == value; }, s);
+}
+
+/**
+ * The first element that matches.  The left half is searched before the
+ * right, and a piece is skipped when a match has already been found
+ * before it - it could only contain later matches.
+ */
+template <typename Pred>
+const int* find_if(const int* first, const int* last, Pred pred,
+                   WorkStealingScheduler& s = WorkStealingScheduler::shared())
+{
+    std::atomic<std::ptrdiff_t> best(last - first);
+
+    struct Search {
+        const int* origin;
+        Pred& pred;
+        std::atomic<std::ptrdiff_t>& best;
+        WorkStealingScheduler& s;
+
+        void operator()(const int* b, const int* e) const
+        {
+            if (best.load(std::memory_order_relaxed) <= b - origin)
+                return;     // cancelled - an earlier match exists
+            if (e - b <= GRAIN) {
+                for (const int* p = b; p != e; ++p) {
+                    if (pred(*p)) {
+                        std::ptrdiff_t index = p - origin;
+                        std::ptrdiff_t current = best.load(std::memory_order_relaxed);
+                        while (index < current && !best.compare_exchange_weak(current, index))
+                            ;
+                        return;
+                    }
+                }
+                return;
+            }
+            const int* mid = b + (e - b) / 2;
+            s.fork_join([&] { (*this)(b, mid); }, [&] { (*this)(mid, e); });
+        }
+    };
+
+    s.run([&] { Search{first, pred, best, s}(first, last); });
+    return first + best.load();
+}
+
+inline const int* find(const int* first, const int* last, int value,
+                       WorkStealingScheduler& s = WorkStealingScheduler::shared())
+{
+    return steal::find_if(first, last, [value](int v) { return v == value; }, s);
+}
+
+template <typename Pred>
+bool none_of(const int* first, const int* last, Pred pred,
+             WorkStealingScheduler& s = WorkStealingScheduler::shared())
+{
+    return steal::find_if(first, last, pred, s) == last;
+}
+
+template <typename Pred>
+bool any_of(const int* first, const int* last, Pred pred,
+            WorkStealingScheduler& s = WorkStealingScheduler::shared())
+{
+    return !steal::none_of(first, last, pred, s);
+}
+
+template <typename Pred>
+bool all_of(const int* first, const int* last, Pred pred,
+            WorkStealingScheduler& s = WorkStealingScheduler::shared())
+{
+    return steal::none_of(first, last, [pred](int v) { return !pred(v); }, s);
+}
+
+} // namespace steal
+
+#endif //SAM206_WORK_STEALING_H